@@ -0,0 +1,580 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "uapi_mm.h"
+
+/* Allocator microbenchmark: reproducible workloads over a set of 
+ * structure families, run against the memory manager and against 
+ * the system allocator (run under LD_PRELOAD=libjemalloc.so or 
+ * similar to compare other malloc implementations, libmm_preload.so
+ * puts the memory manager itself behind malloc) */
+
+typedef struct bench_small_ { char payload[16]; } bench_small_t;
+typedef struct bench_emp_ { char name[32]; uint32_t emp_id; } bench_emp_t;
+typedef struct bench_rec_ { char payload[64]; } bench_rec_t;
+typedef struct bench_blob_ { char payload[256]; } bench_blob_t;
+typedef struct bench_page_ { char payload[1024]; } bench_page_t;
+
+
+/* Command line options of the benchmark */
+struct BenchOptions {
+    uint32_t ops{200000};           /* Allocations per workload */
+    uint32_t threads{2};            /* Producer / consumer pairs */
+    uint32_t seed{42};
+    bool thread_safe{true};
+    bool run_mm{true};
+    bool run_system{true};
+    std::string workload{"all"};
+    mm_free_list_policy_t policy{MM_FREE_LIST_WORST_FIT};
+    bool slab{false};
+    uint32_t cpu_cache_capacity{0};
+    bool remote_free{false};
+};
+
+
+/* A registered family and its unit size */
+struct BenchFamily {
+    StructureFamily *structure_family;
+    uint32_t struct_size;
+};
+
+static std::vector<BenchFamily> bench_families;
+
+
+/* Allocator under test, 'family_index' picks the size class */
+struct BenchAllocator {
+    std::string name;
+    std::function<void *(uint32_t family_index, int units)> alloc;
+    std::function<void (void *ptr)> free;
+    std::function<int (uint32_t family_index, int count, void **ptrs)> alloc_batch;
+    std::function<void (void **ptrs, int count)> free_batch;
+    std::function<void *(size_t size)> alloc_bytes;
+};
+
+
+/* Latency samples and totals of one workload run */
+struct BenchResult {
+    uint64_t ops{0};
+    double seconds{0};
+    std::vector<uint32_t> latency_ns;
+    long rss_pages{0};
+    long cache_misses{-1};          /* -1 when no hardware counter is available */
+};
+
+
+/* Resident pages of the process */
+static long bench_rss_pages() {
+    long size_pages{0}, resident_pages{0};
+    std::ifstream statm("/proc/self/statm");
+    statm >> size_pages >> resident_pages;
+    return resident_pages;
+}
+
+
+/* Hardware cache miss counter of the process, threads started later
+ * included, -1 if perf events are not available */
+static int bench_cache_miss_counter_open() {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+
+static inline uint64_t bench_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/* Time one allocator call and record it */
+template <typename Fn>
+static inline auto bench_timed(BenchResult &result, Fn fn) {
+    uint64_t start = bench_now_ns();
+    auto ret = fn();
+    result.latency_ns.push_back((uint32_t)std::min<uint64_t>(bench_now_ns() - start, UINT32_MAX));
+    result.ops++;
+    return ret;
+}
+
+
+static inline void bench_timed_free(BenchResult &result, BenchAllocator &allocator, void *ptr) {
+    bench_timed(result, [&]() { allocator.free(ptr); return 0; });
+}
+
+
+/* Touch the allocation like an application would */
+static inline void *bench_touch(void *ptr, uint32_t size) {
+    if (ptr) {
+        memset(ptr, 0x5a, std::min<uint32_t>(size, 64));
+    }
+    return ptr;
+}
+
+
+/* Allocations only, freed untimed at the end, 'only_family' pins every 
+ * allocation to one family so the RSS shows the per object overhead */
+static void bench_alloc_only(BenchAllocator &allocator, BenchOptions &options, 
+        BenchResult &result, int only_family = -1) {
+    std::mt19937 rng(options.seed);
+    std::vector<void *> live;
+    live.reserve(options.ops);
+
+    for (uint32_t i = 0; i < options.ops; i++) {
+        uint32_t family_index = (only_family < 0) ? 
+            rng() % bench_families.size() : (uint32_t)only_family;
+        live.push_back(bench_touch(bench_timed(result, [&]() { 
+            return allocator.alloc(family_index, 1); }), bench_families[family_index].struct_size));
+    }
+    result.rss_pages = bench_rss_pages();
+    for (void *ptr: live) {
+        allocator.free(ptr);
+    }
+}
+
+
+/* Batches of allocations freed in reverse (LIFO) or allocation (FIFO) order */
+static void bench_batch_free(BenchAllocator &allocator, BenchOptions &options, 
+        BenchResult &result, bool lifo) {
+    const uint32_t batch = 1000;
+    std::mt19937 rng(options.seed);
+    std::vector<void *> live;
+    live.reserve(batch);
+
+    for (uint32_t done = 0; done < options.ops; done += batch) {
+        for (uint32_t i = 0; i < batch; i++) {
+            uint32_t family_index = rng() % bench_families.size();
+            live.push_back(bench_touch(bench_timed(result, [&]() { 
+                return allocator.alloc(family_index, 1); }), bench_families[family_index].struct_size));
+        }
+        result.rss_pages = std::max(result.rss_pages, bench_rss_pages());
+        if (lifo) {
+            std::reverse(live.begin(), live.end());
+        }
+        for (void *ptr: live) {
+            bench_timed_free(result, allocator, ptr);
+        }
+        live.clear();
+    }
+}
+
+
+/* A bounded live set with allocations and frees at random positions,
+ * 'max_units' above one mixes multi-unit arrays into the requests */
+static void bench_random_free(BenchAllocator &allocator, BenchOptions &options, 
+        BenchResult &result, int max_units) {
+    const uint32_t window = 10000;
+    std::mt19937 rng(options.seed);
+    std::vector<void *> live;
+    live.reserve(window);
+
+    for (uint32_t allocated = 0; allocated < options.ops; ) {
+        if (live.size() < window && (live.empty() || rng() % 2)) {
+            uint32_t family_index = rng() % bench_families.size();
+            int units = 1 + rng() % max_units;
+            live.push_back(bench_touch(bench_timed(result, [&]() { 
+                return allocator.alloc(family_index, units); }), 
+                bench_families[family_index].struct_size * units));
+            allocated++;
+        } else {
+            uint32_t victim = rng() % live.size();
+            bench_timed_free(result, allocator, live[victim]);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+        if (allocated % 4096 == 0) {
+            result.rss_pages = std::max(result.rss_pages, bench_rss_pages());
+        }
+    }
+    for (void *ptr: live) {
+        allocator.free(ptr);
+    }
+}
+
+
+/* Untyped buffers of random sizes (mostly small, up to the largest size
+ * class) in a bounded live set freed at random positions */
+static void bench_bytes(BenchAllocator &allocator, BenchOptions &options, BenchResult &result) {
+    const uint32_t window = 10000;
+    std::mt19937 rng(options.seed);
+    std::vector<void *> live;
+    live.reserve(window);
+
+    for (uint32_t allocated = 0; allocated < options.ops; ) {
+        if (live.size() < window && (live.empty() || rng() % 2)) {
+            size_t size = 1 + ((rng() % 8) ? rng() % 256 : rng() % MM_SIZE_CLASS_MAX);
+            live.push_back(bench_touch(bench_timed(result, [&]() { 
+                return allocator.alloc_bytes(size); }), size));
+            allocated++;
+        } else {
+            uint32_t victim = rng() % live.size();
+            bench_timed_free(result, allocator, live[victim]);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+        if (allocated % 4096 == 0) {
+            result.rss_pages = std::max(result.rss_pages, bench_rss_pages());
+        }
+    }
+    for (void *ptr: live) {
+        allocator.free(ptr);
+    }
+}
+
+
+/* Untyped buffers above the largest size class (up to 32 KiB) in a 
+ * bounded live set per thread freed at random positions, every thread
+ * allocating at once (one without locks) */
+static void bench_large_bytes(BenchAllocator &allocator, BenchOptions &options, 
+        BenchResult &result) {
+    const uint32_t window = 256;
+    const uint32_t thread_count = (allocator.name != "mm" || options.thread_safe) ? 
+        options.threads : 1;
+    const uint32_t ops_per_thread = options.ops / thread_count;
+    std::mutex result_lock;
+    std::vector<std::thread> threads;
+
+    for (uint32_t t = 0; t < thread_count; t++) {
+        threads.emplace_back([&, t]() {
+            BenchResult local;
+            std::mt19937 rng(options.seed + t);
+            std::vector<void *> live;
+            live.reserve(window);
+            for (uint32_t allocated = 0; allocated < ops_per_thread; ) {
+                if (live.size() < window && (live.empty() || rng() % 2)) {
+                    size_t size = MM_SIZE_CLASS_MAX + 1 + rng() % (32 * 1024 - MM_SIZE_CLASS_MAX);
+                    live.push_back(bench_touch(bench_timed(local, [&]() { 
+                        return allocator.alloc_bytes(size); }), size));
+                    allocated++;
+                } else {
+                    uint32_t victim = rng() % live.size();
+                    bench_timed_free(local, allocator, live[victim]);
+                    live[victim] = live.back();
+                    live.pop_back();
+                }
+            }
+            for (void *ptr: live) {
+                allocator.free(ptr);
+            }
+            std::lock_guard<std::mutex> guard(result_lock);
+            result.ops += local.ops;
+            result.latency_ns.insert(result.latency_ns.end(), 
+                local.latency_ns.begin(), local.latency_ns.end());
+            result.rss_pages = std::max(result.rss_pages, bench_rss_pages());
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+
+/* Ingest pattern: a batch of records of one family allocated at once and 
+ * freed all at the end, latency is the batch time spread over its objects */
+static void bench_batch(BenchAllocator &allocator, BenchOptions &options, BenchResult &result) {
+    const uint32_t batch = 1000;
+    std::mt19937 rng(options.seed);
+    std::vector<void *> live(batch);
+
+    for (uint32_t done = 0; done < options.ops; done += batch) {
+        uint32_t family_index = rng() % bench_families.size();
+        uint64_t start = bench_now_ns();
+        int allocated = allocator.alloc_batch(family_index, batch, live.data());
+        uint64_t per_object = (bench_now_ns() - start) / batch;
+        for (int i = 0; i < allocated; i++) {
+            bench_touch(live[i], bench_families[family_index].struct_size);
+        }
+        result.rss_pages = std::max(result.rss_pages, bench_rss_pages());
+
+        start = bench_now_ns();
+        allocator.free_batch(live.data(), allocated);
+        per_object += (bench_now_ns() - start) / batch;
+        result.latency_ns.insert(result.latency_ns.end(), allocated, (uint32_t)per_object / 2);
+        result.ops += 2 * allocated;
+    }
+}
+
+
+/* Producer threads allocate, consumer threads free what they receive */
+static void bench_producer_consumer(BenchAllocator &allocator, BenchOptions &options, 
+        BenchResult &result) {
+    std::mutex queue_lock;
+    std::condition_variable queue_cv;
+    std::deque<void *> queue;
+    uint32_t producers_done{0};
+    std::mutex result_lock;
+    std::vector<std::thread> threads;
+    const uint32_t ops_per_producer = options.ops / options.threads;
+
+    for (uint32_t t = 0; t < options.threads; t++) {
+        threads.emplace_back([&, t]() {
+            BenchResult local;
+            std::mt19937 rng(options.seed + t);
+            std::vector<void *> chunk;
+            for (uint32_t i = 0; i < ops_per_producer; i++) {
+                uint32_t family_index = rng() % bench_families.size();
+                chunk.push_back(bench_touch(bench_timed(local, [&]() { 
+                    return allocator.alloc(family_index, 1); }), 
+                    bench_families[family_index].struct_size));
+                if (chunk.size() == 64 || i + 1 == ops_per_producer) {
+                    std::lock_guard<std::mutex> guard(queue_lock);
+                    queue.insert(queue.end(), chunk.begin(), chunk.end());
+                    queue_cv.notify_one();
+                    chunk.clear();
+                }
+            }
+            std::lock_guard<std::mutex> guard(result_lock);
+            result.ops += local.ops;
+            result.latency_ns.insert(result.latency_ns.end(), 
+                local.latency_ns.begin(), local.latency_ns.end());
+            producers_done++;
+            queue_cv.notify_all();
+        });
+        threads.emplace_back([&]() {
+            BenchResult local;
+            std::vector<void *> chunk;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> guard(queue_lock);
+                    queue_cv.wait(guard, [&]() { 
+                        return !queue.empty() || producers_done == options.threads; });
+                    if (queue.empty()) {
+                        break;
+                    }
+                    size_t take = std::min<size_t>(queue.size(), 64);
+                    chunk.assign(queue.begin(), queue.begin() + take);
+                    queue.erase(queue.begin(), queue.begin() + take);
+                }
+                for (void *ptr: chunk) {
+                    bench_timed_free(local, allocator, ptr);
+                }
+            }
+            std::lock_guard<std::mutex> guard(result_lock);
+            result.ops += local.ops;
+            result.latency_ns.insert(result.latency_ns.end(), 
+                local.latency_ns.begin(), local.latency_ns.end());
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    result.rss_pages = bench_rss_pages();
+}
+
+
+static uint32_t bench_percentile(std::vector<uint32_t> &sorted, double percentile) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[std::min<size_t>(sorted.size() - 1, (size_t)(percentile * sorted.size()))];
+}
+
+
+/* Run one workload and print a line of the result table */
+static void bench_run(const std::string &workload, BenchAllocator &allocator, 
+        BenchOptions &options, std::function<void (BenchResult &)> body) {
+    BenchResult result;
+    long rss_before = bench_rss_pages();
+    int miss_counter = bench_cache_miss_counter_open();
+
+    result.latency_ns.reserve(options.ops * 2);
+    if (miss_counter >= 0) {
+        ioctl(miss_counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    uint64_t start = bench_now_ns();
+    body(result);
+    result.seconds = (bench_now_ns() - start) / 1e9;
+    if (miss_counter >= 0) {
+        ioctl(miss_counter, PERF_EVENT_IOC_DISABLE, 0);
+        long long misses{0};
+        if (read(miss_counter, &misses, sizeof(misses)) == sizeof(misses)) {
+            result.cache_misses = (long)misses;
+        }
+        close(miss_counter);
+    }
+
+    if (allocator.name == "mm") {
+        mm_thread_cache_flush();
+        mm_cpu_cache_flush();
+        mm_page_cache_release();
+    }
+
+    std::sort(result.latency_ns.begin(), result.latency_ns.end());
+    std::cout << std::left << std::setw(20) << workload
+              << std::setw(8) << allocator.name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(2) 
+              << result.ops / result.seconds / 1e6
+              << std::setw(10) << bench_percentile(result.latency_ns, 0.50)
+              << std::setw(10) << bench_percentile(result.latency_ns, 0.99)
+              << std::setw(10) << bench_percentile(result.latency_ns, 0.999)
+              << std::setw(12) << std::max(0L, result.rss_pages - rss_before);
+    if (result.cache_misses >= 0 && result.ops) {
+        std::cout << std::setw(12) << (double)result.cache_misses / result.ops << std::endl;
+    } else {
+        std::cout << std::setw(12) << "-" << std::endl;
+    }
+}
+
+
+static void bench_usage(const char *prog) {
+    std::cout << "Usage: " << prog << " [options]\n"
+              << "  --ops N            allocations per workload (default 200000)\n"
+              << "  --threads N        producer/consumer pairs, large_bytes threads (default 2)\n"
+              << "  --seed N           random seed (default 42)\n"
+              << "  --workload NAME    alloc_only|small_only|lifo|fifo|random|mixed|\n"
+              << "                     batch|bytes|large_bytes|producer_consumer|all\n"
+              << "  --allocator NAME   mm|system|both (default both)\n"
+              << "  --policy NAME      worst|segregated|best|address free block index\n"
+              << "                     (default worst)\n"
+              << "  --slab             serve single units from slab pages\n"
+              << "  --cpu-cache N      blocks each CPU caches per family (default 0, off)\n"
+              << "  --remote-free      free through the lock free stack of each family\n"
+              << "  --single-threaded  init the manager without locks, skips producer_consumer\n";
+}
+
+
+int main(int argc, char **argv) {
+
+    BenchOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--ops" && i + 1 < argc) options.ops = std::stoul(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) options.threads = std::max(1ul, std::stoul(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc) options.seed = std::stoul(argv[++i]);
+        else if (arg == "--workload" && i + 1 < argc) options.workload = argv[++i];
+        else if (arg == "--allocator" && i + 1 < argc) {
+            std::string name = argv[++i];
+            options.run_mm = (name == "mm" || name == "both");
+            options.run_system = (name == "system" || name == "both");
+        }
+        else if (arg == "--policy" && i + 1 < argc) {
+            std::string name = argv[++i];
+            options.policy = (name == "segregated") ? MM_FREE_LIST_SEGREGATED_FIT :
+                             (name == "best") ? MM_FREE_LIST_BEST_FIT :
+                             (name == "address") ? MM_FREE_LIST_ADDRESS_ORDERED : 
+                             MM_FREE_LIST_WORST_FIT;
+        }
+        else if (arg == "--slab") options.slab = true;
+        else if (arg == "--cpu-cache" && i + 1 < argc) options.cpu_cache_capacity = std::stoul(argv[++i]);
+        else if (arg == "--remote-free") options.remote_free = true;
+        else if (arg == "--single-threaded") options.thread_safe = false;
+        else {
+            bench_usage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    MmInitOptions init_options;
+    init_options.thread_safe = options.thread_safe;
+    init_options.cpu_cache_capacity = options.cpu_cache_capacity;
+    init_options.remote_free = options.remote_free;
+    mm_init(init_options);
+
+    bench_families = {
+        {MM_REG_STRUCT(bench_small_), sizeof(bench_small_t)},
+        {MM_REG_STRUCT(bench_emp_), sizeof(bench_emp_t)},
+        {MM_REG_STRUCT(bench_rec_), sizeof(bench_rec_t)},
+        {MM_REG_STRUCT(bench_blob_), sizeof(bench_blob_t)},
+        {MM_REG_STRUCT(bench_page_), sizeof(bench_page_t)},
+    };
+    for (auto &bench_family: bench_families) {
+        mm_set_structure_family_free_list_policy(bench_family.structure_family, options.policy);
+        mm_set_structure_family_slab_mode(bench_family.structure_family, options.slab);
+    }
+
+    std::vector<BenchAllocator> allocators;
+    if (options.run_mm) {
+        allocators.push_back({"mm",
+            [](uint32_t family_index, int units) { 
+                return xcalloc(bench_families[family_index].structure_family, units); },
+            [](void *ptr) { xfree(ptr); },
+            [](uint32_t family_index, int count, void **ptrs) {
+                return xcalloc_batch(bench_families[family_index].structure_family, 1, count, ptrs); },
+            [](void **ptrs, int count) { xfree_batch(ptrs, count); },
+            [](size_t size) { return xcalloc(size); }});
+    }
+    if (options.run_system) {
+        allocators.push_back({"system",
+            [](uint32_t family_index, int units) { 
+                return calloc(units, bench_families[family_index].struct_size); },
+            [](void *ptr) { free(ptr); },
+            [](uint32_t family_index, int count, void **ptrs) {
+                for (int i = 0; i < count; i++) {
+                    ptrs[i] = calloc(1, bench_families[family_index].struct_size);
+                }
+                return count; },
+            [](void **ptrs, int count) {
+                for (int i = 0; i < count; i++) {
+                    free(ptrs[i]);
+                } },
+            [](size_t size) { return calloc(1, size); }});
+    }
+
+    std::cout << "ops = " << options.ops << ", threads = " << options.threads 
+              << ", page size = " << getpagesize() << " Bytes" << std::endl;
+    std::cout << std::left << std::setw(20) << "workload" << std::setw(8) << "alloc"
+              << std::right << std::setw(12) << "Mops/s" << std::setw(10) << "p50 ns"
+              << std::setw(10) << "p99 ns" << std::setw(10) << "p999 ns"
+              << std::setw(12) << "RSS pages" << std::setw(12) << "misses/op" << std::endl;
+
+    auto selected = [&](const std::string &workload) {
+        return options.workload == "all" || options.workload == workload;
+    };
+
+    for (auto &allocator: allocators) {
+        if (selected("alloc_only")) 
+            bench_run("alloc_only", allocator, options, [&](BenchResult &result) {
+                bench_alloc_only(allocator, options, result); });
+        if (selected("small_only")) 
+            bench_run("small_only", allocator, options, [&](BenchResult &result) {
+                bench_alloc_only(allocator, options, result, 0); });
+        if (selected("lifo")) 
+            bench_run("lifo", allocator, options, [&](BenchResult &result) {
+                bench_batch_free(allocator, options, result, true); });
+        if (selected("fifo")) 
+            bench_run("fifo", allocator, options, [&](BenchResult &result) {
+                bench_batch_free(allocator, options, result, false); });
+        if (selected("random")) 
+            bench_run("random", allocator, options, [&](BenchResult &result) {
+                bench_random_free(allocator, options, result, 1); });
+        if (selected("mixed")) 
+            bench_run("mixed", allocator, options, [&](BenchResult &result) {
+                bench_random_free(allocator, options, result, 8); });
+        if (selected("batch")) 
+            bench_run("batch", allocator, options, [&](BenchResult &result) {
+                bench_batch(allocator, options, result); });
+        if (selected("bytes")) 
+            bench_run("bytes", allocator, options, [&](BenchResult &result) {
+                bench_bytes(allocator, options, result); });
+        if (selected("large_bytes")) 
+            bench_run("large_bytes", allocator, options, [&](BenchResult &result) {
+                bench_large_bytes(allocator, options, result); });
+        if (selected("producer_consumer") && (allocator.name != "mm" || options.thread_safe)) 
+            bench_run("producer_consumer", allocator, options, [&](BenchResult &result) {
+                bench_producer_consumer(allocator, options, result); });
+    }
+    return 0;
+}
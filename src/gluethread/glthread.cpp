@@ -153,7 +153,7 @@ glthread_priority_insert(glthread_t *base_glthread,
             continue;
         }
 
-        glthread_add_next(curr, glthread);
+        glthread_add_before(curr, glthread); // first node the new one precedes
         return;
 
     }ITERATE_GLTHREAD_END(base_glthread, curr);
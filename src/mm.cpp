@@ -6,40 +6,316 @@
 #include <assert.h>
 #include <iomanip>
 #include <sstream>
+#include <fstream>
+#include <unordered_map>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <sys/random.h>
+#include <pthread.h>
+#include <linux/mempolicy.h>
 #include "mm.h"
 #include "uapi_mm.h"
 #include "gluethread/glthread.h"
 
 
 size_t SYSTEM_PAGE_SIZE{0};
+static size_t HUGE_PAGE_SIZE{2 * 1024 * 1024};
 static PageForStructFamilies *first_vm_page_for_families{nullptr};
 
+/* Hashed name index over all registered structure families,
+ * serves the legacy string based APIs */
+static std::unordered_map<std::string, StructureFamily*> structure_family_name_index;
+static uint32_t structure_family_count{0};
+
+/* Guards the pages for families and the name index in thread safe mode */
+static std::mutex structure_family_registration_lock;
+
+static MmInitOptions mm_init_options;
+
+/* Arenas with pages left to hand out, per NUMA node pool */
+static glthread_t available_arena_list_head[MM_MAX_NUMA_NODES + 1];
+static uint32_t arena_count{0};
+static uint32_t arena_count_per_pool[MM_MAX_NUMA_NODES + 1];
+static std::mutex arena_lock;
+
+/* Global pools of empty pages retained for reuse by any family, kept
+ * off the pages so a decayed page is not faulted back in by a link,
+ * one per NUMA node pool so a reused page stays on its node */
+static std::vector<CachedPage> cached_pages_global[MM_MAX_NUMA_NODES + 1];
+static std::mutex page_cache_global_lock;
+
+/* NUMA nodes of the host, pages of the families and regions per node pool,
+ * and the node the calling thread asked its pages to be placed on */
+static uint32_t numa_node_count{1};
+static std::atomic<uint64_t> numa_pool_page_count[MM_MAX_NUMA_NODES + 1];
+static thread_local int thread_numa_node{MM_NUMA_NODE_ANY};
+static thread_local ThreadCache thread_cache;
+
+/* Caches of every configured CPU, indexed by the CPU a thread runs on */
+static std::unique_ptr<CpuCache[]> cpu_caches;
+static uint32_t cpu_cache_count{0};
+
+/* Internal families of the size classes and the medium one, registered on first use */
+static std::atomic<StructureFamily*> size_class_families[MM_SIZE_CLASS_COUNT + 1 + MM_SIZE_CLASS_RUN_PAGES];
+static std::mutex size_class_registration_lock;
+
+/* Regions alive and the pages they hold, regions are owned by one thread each */
+static std::atomic<uint64_t> region_count{0};
+static std::atomic<uint64_t> region_page_count{0};
+
+/* Mixed into the cookie of the pages handed out, drawn once in 'mm_init' */
+static uint32_t page_cookie_secret{0};
+
+/* Set once the fork handlers are registered, 'mm_init' may run again */
+static vm_bool fork_handlers_registered{MM_FALSE};
+
+
+/* Lock 'mutex' only if the memory manager runs in thread safe mode */
+static inline std::unique_lock<std::mutex>
+mm_lock_if_thread_safe(std::mutex &mutex) {
+    if (mm_init_options.thread_safe) {
+        return std::unique_lock<std::mutex>(mutex);
+    }
+    return std::unique_lock<std::mutex>(mutex, std::defer_lock);
+}
+
+
+/* Single units go through the calling thread's cache in thread safe mode,
+ * until the cache is torn down on thread exit */
+static inline vm_bool
+mm_thread_cache_enabled() {
+    return (mm_init_options.thread_safe && !thread_cache.torn_down) ? MM_TRUE : MM_FALSE;
+}
+
+
+/* Cookie of a page handed out to a family, tied to the page address so
+ * a copy of a page header elsewhere does not pass for a live page */
+static inline uint32_t
+mm_page_cookie(PageForApplication *page_for_appln) {
+    return (uint32_t)(((uintptr_t)page_for_appln >> 12) * 0x9e3779b1u) ^ page_cookie_secret;
+}
+
+
+/* Read the default huge page size of the system, 2 MiB if unknown */
+static size_t mm_get_huge_page_size() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+    size_t huge_page_size_kb{0};
+
+    while (std::getline(meminfo, line)) {
+        if (sscanf(line.c_str(), "Hugepagesize: %zu kB", &huge_page_size_kb) == 1) {
+            return huge_page_size_kb * 1024;
+        }
+    }
+    return 2 * 1024 * 1024;
+}
+
+
+/* Protection of every mapping made by the memory manager */
+static int mm_vm_page_protection() {
+    return PROT_READ|PROT_WRITE|(mm_init_options.executable ? PROT_EXEC : 0);
+}
+
+
+/* Fault in a mapping up front, writable so no copy on write fault follows */
+static void mm_prefault_vm_pages(void *vm_page, size_t size) {
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(vm_page, size, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+    for (size_t offset = 0; offset < size; offset += SYSTEM_PAGE_SIZE) {
+        ((volatile char *)vm_page)[offset] = 0;
+    }
+}
+
+
+/* Number of possible NUMA nodes of the host, 1 if it is not a NUMA host */
+static uint32_t mm_get_numa_node_count() {
+    std::ifstream node_possible("/sys/devices/system/node/possible");
+    std::string nodes;
+    uint32_t last_node{0};
+
+    /* A list of node ranges such as "0" or "0-3" */
+    if (!(node_possible >> nodes)) {
+        return 1;
+    }
+    last_node = std::stoul(nodes.substr(nodes.find_last_of(",-") + 1));
+    return std::min(last_node + 1, MM_MAX_NUMA_NODES);
+}
+
+
+/* Place 'size' bytes of fresh mappings on a NUMA node before they are 
+ * touched, placement is only a hint so a kernel refusing it is ignored */
+static void 
+mm_numa_place_vm_pages(void *vm_page, size_t size, int numa_node) {
+    unsigned long node_mask{0};
+
+    if (numa_node == MM_NUMA_NODE_ANY) {
+        return;
+    }
+    node_mask = 1UL << numa_node;
+    syscall(SYS_mbind, vm_page, size, 
+        mm_init_options.numa_strict ? MPOL_BIND : MPOL_PREFERRED,
+        &node_mask, sizeof(node_mask) * 8 + 1, MPOL_MF_MOVE);
+}
+
+
+/* The NUMA node a new page of the family is placed on,
+ * a family binding comes first, then the thread's, then the policy */
+static int
+mm_numa_node_for(StructureFamily *structure_family) {
+    unsigned int cpu{0}, numa_node{0};
+
+    if (structure_family && structure_family->numa_node != MM_NUMA_NODE_ANY) {
+        return structure_family->numa_node;
+    }
+    if (thread_numa_node != MM_NUMA_NODE_ANY) {
+        return thread_numa_node;
+    }
+    if (mm_init_options.numa_policy == MM_NUMA_LOCAL && 
+            syscall(SYS_getcpu, &cpu, &numa_node, nullptr) == 0 && 
+            numa_node < numa_node_count) {
+        return (int)numa_node;
+    }
+    return MM_NUMA_NODE_ANY;
+}
+
+
+/* Take every lock of the memory manager in the lock order before a fork,
+ * so the child does not inherit one held by a thread that is not there,
+ * the thread caches stay with their threads */
+static void
+mm_fork_prepare() {
+
+    if (!mm_init_options.thread_safe) {
+        return;
+    }
+    size_class_registration_lock.lock();
+    structure_family_registration_lock.lock();
+    for (uint32_t cpu = 0; cpu < cpu_cache_count; cpu++) {
+        cpu_caches[cpu].cpu_lock.lock();
+    }
+    for (PageForStructFamilies *vm_page_for_families = first_vm_page_for_families; 
+            vm_page_for_families; vm_page_for_families = vm_page_for_families->next) {
+        for (auto &structure_family: *vm_page_for_families) {
+            structure_family.family_lock.lock();
+        }
+    }
+    page_cache_global_lock.lock();
+    arena_lock.lock();
+}
+
+
+/* Release the locks taken by 'mm_fork_prepare' in the reverse order,
+ * in the parent and in the child alike */
+static void
+mm_fork_release() {
+
+    if (!mm_init_options.thread_safe) {
+        return;
+    }
+    arena_lock.unlock();
+    page_cache_global_lock.unlock();
+    for (PageForStructFamilies *vm_page_for_families = first_vm_page_for_families; 
+            vm_page_for_families; vm_page_for_families = vm_page_for_families->next) {
+        for (auto &structure_family: *vm_page_for_families) {
+            structure_family.family_lock.unlock();
+        }
+    }
+    for (uint32_t cpu = cpu_cache_count; cpu > 0; cpu--) {
+        cpu_caches[cpu - 1].cpu_lock.unlock();
+    }
+    structure_family_registration_lock.unlock();
+    size_class_registration_lock.unlock();
+}
+
 
 /* Initialize the global page size for the memory manager */
 void mm_init() {
+    mm_init(MmInitOptions());
+}
+
+
+/* Initialize the memory manager with the given options */
+void mm_init(const MmInitOptions &options) {
     /* Get the size of each memory page, 
      * Memory page is 4096 Bytes in my wsl2 */
     SYSTEM_PAGE_SIZE = getpagesize();
+    if (SYSTEM_PAGE_SIZE > MM_MAX_SYSTEM_PAGE_SIZE) {
+        std::cerr << "Error: VM pages of " << SYSTEM_PAGE_SIZE 
+                  << " Bytes are too big for the meta blocks" << std::endl;
+        exit(-1);
+    }
+
+    mm_init_options = options;
+    mm_init_options.thread_cache_capacity = std::min(
+        mm_init_options.thread_cache_capacity, MM_THREAD_CACHE_MAX_CAPACITY);
+    mm_init_options.thread_cache_batch = std::max(1u, std::min(
+        mm_init_options.thread_cache_batch, mm_init_options.thread_cache_capacity));
+    mm_init_options.cpu_cache_capacity = std::min(
+        mm_init_options.cpu_cache_capacity, MM_CPU_CACHE_MAX_CAPACITY);
+
+    /* A CPU cache takes a whole thread cache at once */
+    if (mm_init_options.thread_safe && mm_init_options.cpu_cache_capacity) {
+        mm_init_options.cpu_cache_capacity = std::max(
+            mm_init_options.cpu_cache_capacity, mm_init_options.thread_cache_capacity);
+        cpu_cache_count = std::max(1L, sysconf(_SC_NPROCESSORS_CONF));
+        cpu_caches.reset(new CpuCache[cpu_cache_count]);
+    }
+
+    /* Huge pages are only used through arenas of at least one huge page */
+    if (mm_init_options.huge_pages != MM_HUGE_PAGES_NONE) {
+        HUGE_PAGE_SIZE = mm_get_huge_page_size();
+        mm_init_options.arena_size = std::max(mm_init_options.arena_size, HUGE_PAGE_SIZE);
+    }
+
+    /* An arena holds its header page and at least one page for application,
+     * and is aligned to its size so a page finds its arena by masking */
+    if (mm_init_options.arena_size) {
+        size_t arena_size = 2 * SYSTEM_PAGE_SIZE;
+        while (arena_size < mm_init_options.arena_size) {
+            arena_size <<= 1;
+        }
+        mm_init_options.arena_size = arena_size;
+    }
+    numa_node_count = mm_get_numa_node_count();
+    if (getrandom(&page_cookie_secret, sizeof(page_cookie_secret), GRND_NONBLOCK) != 
+            sizeof(page_cookie_secret)) {
+        page_cookie_secret = (uint32_t)(uintptr_t)&page_cookie_secret ^ (uint32_t)getpid();
+    }
+    /* The global page cache never grows past its reserve, 'mm_page_cache_put'
+     * calls no malloc with the lock held which the preload would route
+     * back into the manager (a thread cache flushed at thread exit) */
+    for (uint32_t pool = 0; pool <= MM_MAX_NUMA_NODES; pool++) {
+        init_glthread(&available_arena_list_head[pool]);
+        cached_pages_global[pool].reserve(mm_init_options.page_cache_global_max);
+    }
+    if (!fork_handlers_registered) {
+        pthread_atfork(mm_fork_prepare, mm_fork_release, mm_fork_release);
+        fork_handlers_registered = MM_TRUE;
+    }
 }
 
 
 /* Function to request VM page from kernel, 
- * and returns a pointer to the page we applied */
+ * and returns a pointer to the page we applied, nullptr if the kernel
+ * is out of memory */
 void *mm_get_new_vm_page_from_kernel(int units) {
     void *vm_page = mmap(
         NULL,
         units * SYSTEM_PAGE_SIZE,
-        PROT_READ|PROT_WRITE|PROT_EXEC, /* vm page readable, writable and executable */
-        MAP_PRIVATE|MAP_ANONYMOUS, /* private and anonymous mapping */
+        mm_vm_page_protection(), /* vm page readable and writable */
+        MAP_PRIVATE|MAP_ANONYMOUS| /* private and anonymous mapping */
+            (mm_init_options.prefault ? MAP_POPULATE : 0),
         0, 0
     );
-    /* Terminate the whole program if page allocation fails */
+    /* The failure goes up to the application as a null data block */
     if (vm_page == MAP_FAILED) {
-        std::cerr << "Error: VM Page allocation failed" << std::endl;
-        exit(-1);
+        return nullptr;
     }
-    /* Initialize the page we get all to zeros */
-    memset(vm_page, 0, units * SYSTEM_PAGE_SIZE);
+    /* Anonymous pages are zero filled by the kernel when first touched,
+     * no memset here so the pages are faulted in lazily */
     return vm_page;
 }
 
@@ -53,45 +329,373 @@ void mm_return_page_for_appln_to_kernel(void *vm_page, int units) {
 }
 
 
-/* Instantiate new structure family and accommodate it into the page for families */
-void mm_instantiate_new_structure_family(std::string struct_name, uint32_t struct_size) {
-    PageForStructFamilies *new_vm_page_for_families{nullptr};
+/* Reserve a new arena aligned to its size, the mapping is trimmed
+ * from one twice as big and placed on 'numa_node', with the arena lock held,
+ * returns nullptr if the kernel is out of memory */
+static ArenaHeader *
+mm_new_arena(int numa_node) {
 
-    /* Not allowed since structure needs continuous page memory */
-    if (struct_size > SYSTEM_PAGE_SIZE) { 
-        std::cerr << "Error: Structure " << struct_name << " size exceeds system page size" << std::endl;
-        exit(-1);
+    size_t arena_size = mm_init_options.arena_size;
+    void *mapping = MAP_FAILED;
+    vm_bool hugetlb = MM_FALSE;
+
+    /* Mapped directly, the pages are faulted in lazily as they are handed out,
+     * an empty hugetlbfs pool falls back to transparent huge pages */
+    if (mm_init_options.huge_pages == MM_HUGE_PAGES_HUGETLB) {
+        mapping = mmap(NULL, 2 * arena_size, mm_vm_page_protection(),
+            MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, 0, 0);
+        hugetlb = (mapping != MAP_FAILED) ? MM_TRUE : MM_FALSE;
+    }
+    if (mapping == MAP_FAILED) {
+        mapping = mmap(NULL, 2 * arena_size, mm_vm_page_protection(),
+            MAP_PRIVATE|MAP_ANONYMOUS, 0, 0);
+    }
+    char *reserved = static_cast<char*>(mapping);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    char *aligned = (char *)(((uintptr_t)reserved + arena_size - 1) & ~(uintptr_t)(arena_size - 1));
+
+    if (aligned != reserved) {
+        munmap(reserved, aligned - reserved);
+    }
+    munmap(aligned + arena_size, reserved + arena_size - aligned);
+    mm_numa_place_vm_pages(aligned, arena_size, numa_node);
+
+    if (mm_init_options.huge_pages != MM_HUGE_PAGES_NONE && !hugetlb) {
+        madvise(aligned, arena_size, MADV_HUGEPAGE);
+    }
+    if (mm_init_options.prefault) {
+        mm_prefault_vm_pages(aligned, arena_size);
+    }
+
+    ArenaHeader *arena = reinterpret_cast<ArenaHeader*>(aligned);
+    init_glthread(&arena->available_glue);
+    arena->page_count = arena_size / SYSTEM_PAGE_SIZE - 1;
+    arena->bump_index = 0;
+    arena->in_use_count = 0;
+    arena->free_page_list = nullptr;
+    arena->numa_node = numa_node;
+    glthread_add_next(&available_arena_list_head[mm_numa_pool(numa_node)], 
+        &arena->available_glue);
+    arena_count++;
+    arena_count_per_pool[mm_numa_pool(numa_node)]++;
+    return arena;
+}
+
+
+/* Get a page for application placed on 'numa_node', carved out of an 
+ * arena of the node when arenas are enabled, the page run of a large 
+ * object is mapped on its own, 'zeroed' tells if the page is known to
+ * be zero filled, returns nullptr if the kernel is out of memory */
+static void *
+mm_get_vm_page_for_appln(int units, vm_bool *zeroed, int numa_node) {
+
+    ArenaHeader *arena{nullptr};
+    void *vm_page{nullptr};
+    glthread_t *available_arena_list = &available_arena_list_head[mm_numa_pool(numa_node)];
+
+    *zeroed = MM_TRUE;
+    if (units != 1 || mm_init_options.arena_size == 0) {
+        vm_page = mm_get_new_vm_page_from_kernel(units);
+        if (vm_page) {
+            mm_numa_place_vm_pages(vm_page, units * SYSTEM_PAGE_SIZE, numa_node);
+        }
+        return vm_page;
+    }
+
+    std::unique_lock<std::mutex> arena_guard = mm_lock_if_thread_safe(arena_lock);
+    if (IS_GLTHREAD_LIST_EMPTY(available_arena_list)) {
+        arena = mm_new_arena(numa_node);
+        if (arena == nullptr) {
+            return nullptr;
+        }
+    } else {
+        arena = arena_available_glue_to_arena(available_arena_list->right);
+    }
+
+    if (arena->free_page_list) {
+        vm_page = arena->free_page_list;
+        arena->free_page_list = *(void **)vm_page;
+        *zeroed = MM_FALSE; /* Handed out before */
+    } else {
+        vm_page = (char *)arena + (++arena->bump_index) * SYSTEM_PAGE_SIZE;
+    }
+    arena->in_use_count++;
+
+    /* A full arena leaves the available list */
+    if (arena->in_use_count == arena->page_count) {
+        remove_glthread(&arena->available_glue);
+    }
+    return vm_page;
+}
+
+
+/* Give a page for application back to its arena, an arena with all 
+ * its pages back is returned to kernel as a whole */
+static void
+mm_return_vm_page_for_appln(void *vm_page, int units) {
+
+    if (units != 1 || mm_init_options.arena_size == 0) {
+        mm_return_page_for_appln_to_kernel(vm_page, units);
+        return;
+    }
+
+    std::unique_lock<std::mutex> arena_guard = mm_lock_if_thread_safe(arena_lock);
+    ArenaHeader *arena = reinterpret_cast<ArenaHeader*>(
+        (uintptr_t)vm_page & ~(uintptr_t)(mm_init_options.arena_size - 1));
+
+    if (arena->in_use_count == arena->page_count) {
+        glthread_add_next(&available_arena_list_head[mm_numa_pool(arena->numa_node)], 
+            &arena->available_glue);
     }
-    /* If the page for structure families has not been constructed, construct a new one */
-    if (first_vm_page_for_families == nullptr) {
-        first_vm_page_for_families = 
-            static_cast<PageForStructFamilies*>(mm_get_new_vm_page_from_kernel(1));
-        first_vm_page_for_families->structure_family.emplace_back(struct_name, struct_size);
-        init_glthread(&first_vm_page_for_families->structure_family.back().free_block_priority_list_head);
-        first_vm_page_for_families->next = nullptr;
+    arena->in_use_count--;
+
+    if (arena->in_use_count == 0) {
+        remove_glthread(&arena->available_glue);
+        arena_count--;
+        arena_count_per_pool[mm_numa_pool(arena->numa_node)]--;
+        mm_return_page_for_appln_to_kernel(arena, 
+            (int)(mm_init_options.arena_size / SYSTEM_PAGE_SIZE));
         return;
     }
-    /* If the first page for structure families has been full, construct a new one */
-    if (first_vm_page_for_families->structure_family.size() == MAX_FAMILIES_PER_VM_PAGE) {
-        new_vm_page_for_families = 
-            static_cast<PageForStructFamilies*>(mm_get_new_vm_page_from_kernel(1));
-        new_vm_page_for_families->next = first_vm_page_for_families;
-        first_vm_page_for_families = new_vm_page_for_families;
+    *(void **)vm_page = arena->free_page_list;
+    arena->free_page_list = vm_page;
+}
+
+
+/* Take an empty page placed on 'numa_node' retained for reuse, from the 
+ * family pool first, then from the global pool of the node, with the family
+ * lock held, 'zeroed' tells if the page is known to be zero filled 
+ * (decommitted by a successful MADV_DONTNEED), a null family only uses
+ * the global pool */
+static void *
+mm_page_cache_get(StructureFamily *structure_family, vm_bool *zeroed, int numa_node) {
+
+    PageForApplication *cached_page{nullptr};
+    std::vector<CachedPage> &cached_pages = 
+        cached_pages_global[mm_numa_pool(numa_node)];
+
+    *zeroed = MM_FALSE;
+    if (structure_family && structure_family->first_cached_page &&
+            structure_family->first_cached_page->numa_node == numa_node) {
+        cached_page = structure_family->first_cached_page;
+        structure_family->first_cached_page = cached_page->next;
+        structure_family->cached_page_count--;
+        return cached_page;
+    }
+
+    std::unique_lock<std::mutex> page_cache_lock = 
+        mm_lock_if_thread_safe(page_cache_global_lock);
+    if (!cached_pages.empty()) {
+        cached_page = cached_pages.back().page;
+        *zeroed = cached_pages.back().zeroed;
+        cached_pages.pop_back();
+    }
+    return cached_page;
+}
+
+
+/* Retain an empty page for reuse instead of unmapping it, in the global
+ * pool of its NUMA node after the family pool, with the family lock held,
+ * returns false if both pools are at the high-water mark,
+ * a null family only uses the global pool */
+static vm_bool
+mm_page_cache_put(StructureFamily *structure_family, PageForApplication *empty_page) {
+
+    vm_bool zeroed = MM_FALSE;
+
+    if (structure_family && 
+            structure_family->cached_page_count < mm_init_options.page_cache_family_max) {
+        empty_page->next = structure_family->first_cached_page;
+        structure_family->first_cached_page = empty_page;
+        structure_family->cached_page_count++;
+        return MM_TRUE;
+    }
+
+    std::unique_lock<std::mutex> page_cache_lock = 
+        mm_lock_if_thread_safe(page_cache_global_lock);
+    std::vector<CachedPage> &cached_pages = 
+        cached_pages_global[mm_numa_pool(empty_page->numa_node)];
+    if (cached_pages.size() >= mm_init_options.page_cache_global_max) {
+        return MM_FALSE;
+    }
+
+    /* Pages going cold in the global pool give their memory back, 
+     * the mapping stays so reuse costs no mmap, pages of huge page arenas 
+     * keep it: a 4 KiB madvise fails with EINVAL on hugetlb pages and 
+     * splits a transparent huge page */
+    if (mm_init_options.huge_pages != MM_HUGE_PAGES_NONE) {
+        cached_pages.push_back({empty_page, MM_FALSE});
+        return MM_TRUE;
+    }
+    if (mm_init_options.page_cache_decay == MM_PAGE_CACHE_DECAY_DONTNEED) {
+        zeroed = (madvise(empty_page, SYSTEM_PAGE_SIZE, MADV_DONTNEED) == 0) ? 
+            MM_TRUE : MM_FALSE;
+    }
+#ifdef MADV_FREE
+    if (mm_init_options.page_cache_decay == MM_PAGE_CACHE_DECAY_FREE) {
+        madvise(empty_page, SYSTEM_PAGE_SIZE, MADV_FREE);
+    }
+#endif
+    cached_pages.push_back({empty_page, zeroed});
+    return MM_TRUE;
+}
+
+
+/* Take a freed run of 'page_units' VM pages placed on 'numa_node' 
+ * retained by a page run size class, with the family lock held */
+static void *
+mm_page_run_cache_get(StructureFamily *structure_family, uint32_t page_units, int numa_node) {
+
+    PageForApplication *cached_run = structure_family->first_cached_run;
+
+    if (page_units != structure_family->run_page_units || cached_run == nullptr ||
+            cached_run->numa_node != numa_node) {
+        return nullptr;
+    }
+    structure_family->first_cached_run = cached_run->next;
+    structure_family->cached_run_count--;
+    return cached_run;
+}
+
+
+/* Retain a freed run of a page run size class for reuse instead of 
+ * unmapping it, with the family lock held, returns false if the class
+ * keeps 'page_cache_run_pages' pages already */
+static vm_bool
+mm_page_run_cache_put(StructureFamily *structure_family, PageForApplication *run) {
+
+    uint32_t run_max = std::max<uint32_t>(1, 
+        mm_init_options.page_cache_run_pages / structure_family->run_page_units);
+
+    if (structure_family->cached_run_count >= run_max) {
+        return MM_FALSE;
+    }
+    run->next = structure_family->first_cached_run;
+    structure_family->first_cached_run = run;
+    structure_family->cached_run_count++;
+    return MM_TRUE;
+}
+
+
+/* Return every empty page retained by the page caches back to kernel */
+void mm_page_cache_release() {
+
+    PageForStructFamilies *vm_page_for_families_curr{nullptr};
+    PageForApplication *cached_page{nullptr};
+
+    std::unique_lock<std::mutex> registration_lock = 
+        mm_lock_if_thread_safe(structure_family_registration_lock);
+
+    vm_page_for_families_curr = first_vm_page_for_families;
+    while (vm_page_for_families_curr) {
+        for (auto &structure_family: *vm_page_for_families_curr) {
+            std::unique_lock<std::mutex> family_lock = 
+                mm_lock_if_thread_safe(structure_family.family_lock);
+            while (structure_family.first_cached_page) {
+                cached_page = structure_family.first_cached_page;
+                structure_family.first_cached_page = cached_page->next;
+                mm_return_vm_page_for_appln(cached_page, 1);
+            }
+            structure_family.cached_page_count = 0;
+            while (structure_family.first_cached_run) {
+                cached_page = structure_family.first_cached_run;
+                structure_family.first_cached_run = cached_page->next;
+                mm_return_vm_page_for_appln(cached_page, structure_family.run_page_units);
+            }
+            structure_family.cached_run_count = 0;
+        }
+        vm_page_for_families_curr = vm_page_for_families_curr->next;
+    }
+
+    std::unique_lock<std::mutex> page_cache_lock = 
+        mm_lock_if_thread_safe(page_cache_global_lock);
+    for (auto &cached_pages: cached_pages_global) {
+        for (CachedPage &cached_page_global: cached_pages) {
+            mm_return_vm_page_for_appln(cached_page_global.page, 1);
+        }
+        cached_pages.clear();
+    }
+}
+
+
+/* Construct a new page for structure families and push it to 
+ * the head of the list of pages for families, nullptr if the kernel
+ * is out of memory */
+static PageForStructFamilies *mm_new_vm_page_for_families() {
+    void *vm_page = mm_get_new_vm_page_from_kernel(1);
+    if (vm_page == nullptr) {
+        return nullptr;
+    }
+    PageForStructFamilies *new_vm_page_for_families = 
+        new (vm_page) PageForStructFamilies();
+    new_vm_page_for_families->next = first_vm_page_for_families;
+    first_vm_page_for_families = new_vm_page_for_families;
+    return new_vm_page_for_families;
+}
+
+
+/* Instantiate new structure family and accommodate it into the page for families,
+ * returns the family as a stable handle for the allocation APIs, 
+ * nullptr if the kernel is out of memory */
+StructureFamily *mm_instantiate_new_structure_family(std::string struct_name, 
+        uint32_t struct_size, uint32_t alignment) {
+    StructureFamily *structure_family{nullptr};
+
+    if (alignment == 0 || (alignment & (alignment - 1)) || alignment > MM_MAX_ALIGNMENT) {
+        std::cerr << "Error: Alignment of structure " << struct_name 
+                  << " must be a power of two up to " << MM_MAX_ALIGNMENT << std::endl;
+        exit(-1);
+    }
+    std::unique_lock<std::mutex> registration_lock = 
+        mm_lock_if_thread_safe(structure_family_registration_lock);
+
+    /* A structure bigger than a VM page is served by large page runs */
+    /* Registering the same structure twice hands back the existing family */
+    auto structure_family_iter = structure_family_name_index.find(struct_name);
+    if (structure_family_iter != structure_family_name_index.end()) {
+        structure_family = structure_family_iter->second;
+        if (structure_family->struct_size != struct_size || 
+                structure_family->alignment != alignment) {
+            std::cerr << "Error: Structure " << struct_name 
+                      << " is already registered with a different size or alignment" << std::endl;
+            exit(-1);
+        }
+        return structure_family;
+    }
+    /* If the page for structure families has not been constructed
+     * or the first one has been full, construct a new one */
+    if (first_vm_page_for_families == nullptr || 
+            first_vm_page_for_families->family_count == mm_max_families_per_vm_page()) {
+        if (mm_new_vm_page_for_families() == nullptr) {
+            return nullptr;
+        }
     }
     /* Add the structure to the 'hotel' at the very beginning of the program call by 'MM_REG_STRUCT'*/
-    first_vm_page_for_families->structure_family.emplace_back(struct_name, struct_size);
-    init_glthread(&first_vm_page_for_families->structure_family.back().free_block_priority_list_head);
+    structure_family = new (first_vm_page_for_families->end()) 
+        StructureFamily(struct_name, struct_size);
+    first_vm_page_for_families->family_count++;
+    init_glthread(&structure_family->free_block_priority_list_head);
+    init_glthread(&structure_family->slab_partial_list_head);
+    structure_family->family_id = structure_family_count++;
+    structure_family->alignment = alignment;
+
+    structure_family_name_index[structure_family->struct_name] = structure_family;
+    return structure_family;
 }
 
 
 /* Screen out all the registered structure families*/
 void mm_print_registered_structure_families() {
     
+    std::unique_lock<std::mutex> registration_lock = 
+        mm_lock_if_thread_safe(structure_family_registration_lock);
     PageForStructFamilies* curr_vm_page_for_families{first_vm_page_for_families};
     
     /* Iterate over the vector for structure families */
     while(curr_vm_page_for_families != nullptr) {
-        for (const auto &family: curr_vm_page_for_families->structure_family) {
+        for (const auto &family: *curr_vm_page_for_families) {
             std::cout << "Page Family: " << family.struct_name 
                       << ", Size = " << family.struct_size << std::endl;
         }
@@ -102,8 +706,7 @@ void mm_print_registered_structure_families() {
 
 /* Check if a page for application is empty */
 vm_bool mm_is_page_for_appln_empty(PageForApplication *page_for_appln) {
-    if (page_for_appln->block_meta_data.next_block == nullptr && 
-        page_for_appln->block_meta_data.prev_block == nullptr &&
+    if (next_meta_block(&page_for_appln->block_meta_data) == nullptr && 
         page_for_appln->block_meta_data.is_free == MM_TRUE) {
             return MM_TRUE;
         }
@@ -113,60 +716,139 @@ vm_bool mm_is_page_for_appln_empty(PageForApplication *page_for_appln) {
 
 /* Initialize lower most Meta block of the page for application manual */
 void mm_make_page_for_appln_empty(PageForApplication *page_for_appln) {
-    page_for_appln->block_meta_data.next_block = nullptr;
-    page_for_appln->block_meta_data.prev_block = nullptr;
+    page_for_appln->block_meta_data.prev_offset = 0;
+    page_for_appln->block_meta_data.tail_gap = 0;
     page_for_appln->block_meta_data.is_free = MM_TRUE;
 }
 
 
+/* Head of the family list a page for application is linked into */
+static PageForApplication **
+mm_family_page_list_head(StructureFamily *structure_family, mm_page_kind_t page_kind) {
+    if (page_kind == MM_PAGE_SLAB) {
+        return &structure_family->first_slab_page;
+    }
+    if (page_kind == MM_PAGE_LARGE) {
+        return &structure_family->first_large_page;
+    }
+    return &structure_family->first_page;
+}
+
+
 /* Allocate a memory page for applications
- * Inside the page is meta block and data block */
-PageForApplication *mm_allocate_page_for_application(StructureFamily *structure_family) {
-    PageForApplication *page_for_appln = 
-        static_cast<PageForApplication*>(mm_get_new_vm_page_from_kernel(1));
+ * Inside the page is meta block and data block,
+ * or the slab bookkeeping and the slots for a slab page,
+ * a large page run spans 'page_units' VM pages,
+ * 'page_zeroed' tells if the page is known to be zero filled,
+ * returns nullptr if the kernel is out of memory */
+PageForApplication *mm_allocate_page_for_application(StructureFamily *structure_family,
+        mm_page_kind_t page_kind, uint32_t page_units, vm_bool *page_zeroed) {
+    vm_bool zeroed = MM_FALSE;
+    int numa_node = mm_numa_node_for(structure_family);
+    void *vm_page = mm_page_run_cache_get(structure_family, page_units, numa_node);
+    if (vm_page == nullptr && page_units == 1) {
+        vm_page = mm_page_cache_get(structure_family, &zeroed, numa_node);
+    }
+    if (vm_page == nullptr) {
+        vm_page = mm_get_vm_page_for_appln(page_units, &zeroed, numa_node);
+    }
+    if (vm_page == nullptr) {
+        return nullptr;
+    }
+    PageForApplication *page_for_appln = static_cast<PageForApplication*>(vm_page);
+    PageForApplication **first_page = 
+        mm_family_page_list_head(structure_family, page_kind);
     
-    /* Initialize lower most Meta block of the page for application manually again */
-    mm_make_page_for_appln_empty(page_for_appln);
-
-    page_for_appln->block_meta_data.block_size = 
-        mm_max_page_allocatable_memory(1);
-    page_for_appln->block_meta_data.offset = 
-        offsetof(PageForApplication, block_meta_data);
-    init_glthread(&page_for_appln->block_meta_data.priority_thread_glue);
+    page_for_appln->page_kind = page_kind;
+    page_for_appln->numa_node = numa_node;
+    page_for_appln->page_cookie = mm_page_cookie(page_for_appln);
+    numa_pool_page_count[mm_numa_pool(numa_node)].fetch_add(page_units, std::memory_order_relaxed);
+    if (page_kind == MM_PAGE_LARGE) {
+        page_for_appln->large_page_data.page_units = page_units;
+        page_for_appln->large_page_data.object_offset = MM_LARGE_OBJECT_OFFSET;
+        page_for_appln->large_page_data.object_size = 0;
+    } else if (page_kind == MM_PAGE_SLAB) {
+        page_for_appln->slab_page_data.in_use_count = 0;
+        page_for_appln->slab_page_data.slots_offset = structure_family->slab_slots_offset;
+        page_for_appln->slab_page_data.bump_index = 0;
+        page_for_appln->slab_page_data.free_list = nullptr;
+        page_for_appln->slab_page_data.bump_zeroed = zeroed;
+        init_glthread(&page_for_appln->slab_page_data.partial_glue);
+        memset(page_for_appln->slab_page_data.in_use_bitmap, 0, 
+            sizeof(page_for_appln->slab_page_data.in_use_bitmap));
+    } else {
+        /* Initialize lower most Meta block of the page for application manually again */
+        mm_make_page_for_appln_empty(page_for_appln);
+
+        page_for_appln->block_meta_data.block_size = 
+            mm_max_page_allocatable_memory(1);
+        page_for_appln->block_meta_data.offset = 
+            offsetof(PageForApplication, block_meta_data);
+        page_for_appln->block_meta_data.is_zeroed = zeroed;
+        page_for_appln->block_meta_data.is_indexed = MM_FALSE;
+        page_for_appln->block_meta_data.is_cached = MM_FALSE;
+    }
     page_for_appln->prev = nullptr;
     page_for_appln->next = nullptr;
+    structure_family->counters.page_count += page_units;
+    if (page_zeroed) {
+        *page_zeroed = zeroed;
+    }
 
     /* Set a back pointer to page family */
     page_for_appln->structure_family = structure_family;
 
     /* If it is the first VM data page for a given page family */
-    if (structure_family->first_page == nullptr) {
-        structure_family->first_page = page_for_appln;
+    if (*first_page == nullptr) {
+        *first_page = page_for_appln;
         return page_for_appln;
     }
 
     /* Insert new VM page to the head of the linked list */
-    page_for_appln->next = structure_family->first_page;
-    structure_family->first_page->prev = page_for_appln;
-    structure_family->first_page = page_for_appln;
+    page_for_appln->next = *first_page;
+    (*first_page)->prev = page_for_appln;
+    *first_page = page_for_appln;
     return page_for_appln;
 }
 
 
-/* Delete and free a page for application back to kernel */
+/* Hand an unlinked page for application to the page caches, a run of a
+ * page run size class to the class, or back to kernel if they are full */
+static void
+mm_release_page_for_application(PageForApplication *page_for_appln, int page_units) {
+    page_for_appln->page_cookie = ~mm_page_cookie(page_for_appln);
+    if ((uint32_t)page_units == page_for_appln->structure_family->run_page_units &&
+            mm_page_run_cache_put(page_for_appln->structure_family, page_for_appln)) {
+        return;
+    }
+    if (page_units == 1 && 
+            mm_page_cache_put(page_for_appln->structure_family, page_for_appln)) {
+        return;
+    }
+    mm_return_vm_page_for_appln(static_cast<void*>(page_for_appln), page_units);
+}
+
+
+/* Delete and free a page for application back to kernel (or the page caches) */
 void mm_delete_and_free_page_for_application(PageForApplication *page_for_appln) {
-    StructureFamily *structure_family = 
-        page_for_appln->structure_family;
+    PageForApplication **first_page = mm_family_page_list_head(
+        page_for_appln->structure_family, page_for_appln->page_kind);
+    int page_units = (page_for_appln->page_kind == MM_PAGE_LARGE) ? 
+        page_for_appln->large_page_data.page_units : 1;
+
+    page_for_appln->structure_family->counters.page_count -= page_units;
+    numa_pool_page_count[mm_numa_pool(page_for_appln->numa_node)].fetch_sub(
+        page_units, std::memory_order_relaxed);
 
     /* If the page being deleting is the head of the linked list */
-    if (structure_family->first_page == page_for_appln) {
-        structure_family->first_page = page_for_appln->next;
+    if (*first_page == page_for_appln) {
+        *first_page = page_for_appln->next;
         if (page_for_appln->next != nullptr) {
             page_for_appln->next->prev = nullptr;
         }
         page_for_appln->next = nullptr;
         page_for_appln->prev = nullptr;
-        mm_return_page_for_appln_to_kernel(static_cast<void*>(page_for_appln), 1);
+        mm_release_page_for_application(page_for_appln, page_units);
         return;
     }
 
@@ -175,328 +857,2340 @@ void mm_delete_and_free_page_for_application(PageForApplication *page_for_appln)
         page_for_appln->next->prev = page_for_appln->prev;
     }
     page_for_appln->prev->next = page_for_appln->next;
-    mm_return_page_for_appln_to_kernel(static_cast<void*>(page_for_appln), 1);
+    mm_release_page_for_application(page_for_appln, page_units);
 }
 
 
-/* Local function to compare the block size of two given blocks*/
-static int 
-mm_free_blocks_comparison_function(void *_block_meta_data1, void *_block_meta_data2) {
-    
-    BlockMetaData *block_meta_data1 = 
-        static_cast<BlockMetaData*>(_block_meta_data1);
+/* Take a slot from the first partial slab page of the family,
+ * a new slab page is added if every slab page is full,
+ * 'zeroed' tells if the slot is known to be zero filled */
+static void *
+mm_slab_allocate(StructureFamily *structure_family, vm_bool *zeroed) {
 
-    BlockMetaData *block_meta_data2 = 
-        static_cast<BlockMetaData*>(_block_meta_data1);
+    PageForApplication *page_for_appln{nullptr};
+    void *slot{nullptr};
 
-    if (block_meta_data1->block_size > block_meta_data2->block_size) {
-        return -1;
-    } else if (block_meta_data1->block_size < block_meta_data2->block_size) {
-        return 1;
+    if (IS_GLTHREAD_LIST_EMPTY(&structure_family->slab_partial_list_head)) {
+        page_for_appln = mm_allocate_page_for_application(structure_family, MM_PAGE_SLAB);
+        if (page_for_appln == nullptr) {
+            return nullptr;
+        }
+        glthread_add_next(&structure_family->slab_partial_list_head,
+                          &page_for_appln->slab_page_data.partial_glue);
+    } else {
+        page_for_appln = slab_partial_glue_to_page(
+            structure_family->slab_partial_list_head.right);
     }
-    return 0;
+    SlabPageData *slab_page_data = &page_for_appln->slab_page_data;
+
+    /* Recycled slots first, so the untouched tail of the page stays unfaulted */
+    if (slab_page_data->free_list) {
+        slot = slab_page_data->free_list;
+        slab_page_data->free_list = *(void **)slot;
+        *zeroed = MM_FALSE;
+    } else {
+        *zeroed = slab_page_data->bump_zeroed;
+        slot = mm_slab_page_slots(page_for_appln) + 
+            (slab_page_data->bump_index++) * structure_family->slab_slot_size;
+    }
+    slab_page_data->in_use_count++;
+
+    /* A full slab page leaves the partial list */
+    if (slab_page_data->in_use_count == structure_family->slab_slots_per_page) {
+        remove_glthread(&slab_page_data->partial_glue);
+    }
+    return slot;
 }
 
 
-/* Add a free data block into the priority queue */
-static void 
-mm_add_free_block_meta_data_to_free_block_list(
-        StructureFamily *structure_family,
-        BlockMetaData *free_block) {
-    
-    assert(free_block->is_free = MM_TRUE);
-    glthread_priority_insert(&structure_family->free_block_priority_list_head,
-                             &free_block->priority_thread_glue,
-                             mm_free_blocks_comparison_function,
-                             offsetof(BlockMetaData, priority_thread_glue));
-}
+/* Give a slot back to its slab page, an empty slab page 
+ * is released back to kernel */
+static void
+mm_slab_free(PageForApplication *page_for_appln, void *slot) {
 
+    StructureFamily *structure_family = page_for_appln->structure_family;
+    SlabPageData *slab_page_data = &page_for_appln->slab_page_data;
 
-/* Function to mark block_meta_data as being Allocated for 'size'
- * bytes of application data.
- * Return true if block allocation succeeds */
-static vm_bool
-mm_split_free_data_block_for_application(
-        StructureFamily *structure_family,
-        BlockMetaData *block_meta_data,
-        uint32_t size) {
-    
-    BlockMetaData *next_block_meta_data = nullptr;
+    /* A full slab page gets a free slot, back to the partial list */
+    if (slab_page_data->in_use_count == structure_family->slab_slots_per_page) {
+        glthread_add_next(&structure_family->slab_partial_list_head,
+                          &slab_page_data->partial_glue);
+    }
+    slab_page_data->in_use_count--;
 
-    assert(block_meta_data->is_free = MM_TRUE);
-    if (block_meta_data->block_size < size) {
+    if (slab_page_data->in_use_count == 0) {
+        remove_glthread(&slab_page_data->partial_glue);
+        mm_delete_and_free_page_for_application(page_for_appln);
+        return;
+    }
+    *(void **)slot = slab_page_data->free_list;
+    slab_page_data->free_list = slot;
+}
+
+
+/* Map a run of contiguous VM pages for an object of 'size' bytes too big
+ * for one page (an aligned object may still fit a single recycled page),
+ * a page run size class reuses a run it retained first,
+ * with the family lock held, returns nullptr if the kernel is out of memory */
+static void *
+mm_large_object_allocate(StructureFamily *structure_family, uint64_t size, 
+        uint32_t alignment, vm_bool zero_fill) {
+
+    vm_bool zeroed = MM_FALSE;
+    uint64_t object_offset = mm_align_up(MM_LARGE_OBJECT_OFFSET, alignment);
+
+    /* Page runs are mapped in 'int' units of VM pages */
+    if ((object_offset + size) / SYSTEM_PAGE_SIZE >= (uint64_t)INT32_MAX) {
+        return nullptr;
+    }
+    PageForApplication *page_for_appln = mm_allocate_page_for_application(
+        structure_family, MM_PAGE_LARGE, mm_large_object_page_units(size, object_offset), &zeroed);
+
+    if (page_for_appln == nullptr) {
+        return nullptr;
+    }
+    page_for_appln->large_page_data.object_offset = object_offset;
+    page_for_appln->large_page_data.object_size = size;
+    if (zero_fill && !zeroed) {
+        memset(mm_large_page_object(page_for_appln), 0, size);
+    }
+    return mm_large_page_object(page_for_appln);
+}
+
+
+/* Serve single units of a structure family from slab pages, the slots are
+ * 'struct_size' rounded up to hold the free list link and to the alignment */
+void mm_set_structure_family_slab_mode(
+        StructureFamily *structure_family, bool enable) {
+
+    std::unique_lock<std::mutex> family_lock = 
+        mm_lock_if_thread_safe(structure_family->family_lock);
+
+    /* Geometry is fixed once computed, slab pages may still be alive */
+    if (structure_family->slab_slot_size == 0) {
+        uint32_t slot_alignment = std::max<uint32_t>(structure_family->alignment, sizeof(void *));
+        structure_family->slab_slot_size = mm_align_up(
+            std::max<uint32_t>(structure_family->struct_size, sizeof(void *)), slot_alignment);
+        structure_family->slab_slots_offset = mm_align_up(
+            offsetof(PageForApplication, slab_page_data) + sizeof(SlabPageData), slot_alignment);
+        structure_family->slab_slots_per_page = std::min<uint32_t>(
+            MM_SLAB_MAX_SLOTS_PER_PAGE,
+            (SYSTEM_PAGE_SIZE - structure_family->slab_slots_offset) / 
+                structure_family->slab_slot_size);
+    }
+    if (enable && structure_family->slab_slots_per_page == 0) {
+        std::cerr << "Error: Structure " << structure_family->struct_name 
+                  << " is too big for slab pages" << std::endl;
+        return;
+    }
+    structure_family->slab_mode = enable ? MM_TRUE : MM_FALSE;
+}
+
+
+/* Check a NUMA node given by the application */
+static vm_bool
+mm_is_valid_numa_node(int numa_node) {
+    if (numa_node == MM_NUMA_NODE_ANY || 
+            (numa_node >= 0 && (uint32_t)numa_node < numa_node_count)) {
+        return MM_TRUE;
+    }
+    std::cerr << "Error: NUMA node " << numa_node << " does not exist, the host has "
+              << numa_node_count << " node(s)" << std::endl;
+    return MM_FALSE;
+}
+
+
+/* Place the new pages of a structure family on a NUMA node */
+void mm_set_structure_family_numa_node(StructureFamily *structure_family, int numa_node) {
+
+    if (!mm_is_valid_numa_node(numa_node)) {
+        return;
+    }
+    std::unique_lock<std::mutex> family_lock = 
+        mm_lock_if_thread_safe(structure_family->family_lock);
+    structure_family->numa_node = numa_node;
+}
+
+
+/* Place the new pages the calling thread gets on a NUMA node */
+void mm_set_thread_numa_node(int numa_node) {
+
+    if (!mm_is_valid_numa_node(numa_node)) {
+        return;
+    }
+    thread_numa_node = numa_node;
+}
+
+
+/* Local function to compare the block size of two given blocks*/
+static int 
+mm_free_blocks_comparison_function(void *_block_meta_data1, void *_block_meta_data2) {
+    
+    BlockMetaData *block_meta_data1 = 
+        static_cast<BlockMetaData*>(_block_meta_data1);
+
+    BlockMetaData *block_meta_data2 = 
+        static_cast<BlockMetaData*>(_block_meta_data2);
+
+    if (block_meta_data1->block_size > block_meta_data2->block_size) {
+        return -1;
+    } else if (block_meta_data1->block_size < block_meta_data2->block_size) {
+        return 1;
+    }
+    return 0;
+}
+
+
+/* Local function to compare the address of two given blocks */
+static int 
+mm_free_blocks_address_comparison_function(void *_block_meta_data1, void *_block_meta_data2) {
+
+    if (_block_meta_data1 < _block_meta_data2) {
+        return -1;
+    } else if (_block_meta_data1 > _block_meta_data2) {
+        return 1;
+    }
+    return 0;
+}
+
+
+/* Check if the free block index of a family is made of size class bins */
+static inline vm_bool
+mm_free_list_policy_uses_bins(mm_free_list_policy_t policy) {
+    return (policy == MM_FREE_LIST_SEGREGATED_FIT || 
+            policy == MM_FREE_LIST_BEST_FIT) ? MM_TRUE : MM_FALSE;
+}
+
+
+/* Push a free data block into the segregated fit bin of its size */
+static void
+mm_free_bins_insert(FreeBlockBins *free_block_bins, BlockMetaData *free_block) {
+
+    uint32_t fl, sl;
+
+    mm_free_bin_mapping(free_block->block_size, &fl, &sl);
+    init_glthread(mm_free_block_glue(free_block));
+    glthread_add_next(&free_block_bins->bin_head[fl][sl], 
+                      mm_free_block_glue(free_block));
+    free_block_bins->sl_bitmap[fl] |= (1u << sl);
+    free_block_bins->fl_bitmap |= (1u << fl);
+}
+
+
+/* Unlink a free data block from its segregated fit bin,
+ * the block size must still be the one it was binned with */
+static void
+mm_free_bins_remove(FreeBlockBins *free_block_bins, BlockMetaData *free_block) {
+
+    uint32_t fl, sl;
+
+    mm_free_bin_mapping(free_block->block_size, &fl, &sl);
+    remove_glthread(mm_free_block_glue(free_block));
+
+    if (IS_GLTHREAD_LIST_EMPTY(&free_block_bins->bin_head[fl][sl])) {
+        free_block_bins->sl_bitmap[fl] &= ~(1u << sl);
+        if (free_block_bins->sl_bitmap[fl] == 0) {
+            free_block_bins->fl_bitmap &= ~(1u << fl);
+        }
+    }
+}
+
+
+/* Find a free data block of at least 'req_size' bytes in the bins,
+ * the request is rounded up to the next bin so the first block of the
+ * first non empty bin fits, only the first block of the exact bin of the
+ * request is tried as a fallback so the lookup stays O(1) */
+static BlockMetaData *
+mm_free_bins_find(FreeBlockBins *free_block_bins, uint32_t req_size) {
+
+    uint32_t fl, sl;
+    uint32_t fl_map, sl_map;
+    uint32_t rounded_size = req_size;
+    uint32_t fl_raw = 31 - __builtin_clz(req_size | 1);
+    glthread_t *first{nullptr};
+
+    if (fl_raw >= MM_FREE_BIN_SL_LOG2) {
+        rounded_size += (1u << (fl_raw - MM_FREE_BIN_SL_LOG2)) - 1;
+    }
+    mm_free_bin_mapping(rounded_size, &fl, &sl);
+
+    sl_map = free_block_bins->sl_bitmap[fl] & (~0u << sl);
+    if (sl_map == 0) {
+        fl_map = (fl + 1 < MM_FREE_BIN_FL_COUNT) ? 
+            free_block_bins->fl_bitmap & (~0u << (fl + 1)) : 0;
+        if (fl_map != 0) {
+            fl = __builtin_ctz(fl_map);
+            sl_map = free_block_bins->sl_bitmap[fl];
+        }
+    }
+    if (sl_map != 0) {
+        sl = __builtin_ctz(sl_map);
+        return glthread_to_block_meta_data(free_block_bins->bin_head[fl][sl].right);
+    }
+
+    /* A block sharing the bin of the request may still be big enough */
+    mm_free_bin_mapping(req_size, &fl, &sl);
+    first = free_block_bins->bin_head[fl][sl].right;
+    if (first && glthread_to_block_meta_data(first)->block_size >= req_size) {
+        return glthread_to_block_meta_data(first);
+    }
+    return nullptr;
+}
+
+
+/* Smallest free block of a bin holding at least 'req_size' bytes */
+static BlockMetaData *
+mm_free_bin_smallest_fit(glthread_t *bin_head, uint32_t req_size) {
+
+    BlockMetaData *best_block{nullptr};
+    BlockMetaData *block_meta_data{nullptr};
+    glthread_t *curr{nullptr};
+
+    ITERATE_GLTHREAD_BEGIN(bin_head, curr) {
+        block_meta_data = glthread_to_block_meta_data(curr);
+        if (block_meta_data->block_size >= req_size && 
+                (best_block == nullptr || block_meta_data->block_size < best_block->block_size)) {
+            best_block = block_meta_data;
+        }
+    } ITERATE_GLTHREAD_END(bin_head, curr);
+    return best_block;
+}
+
+
+/* Find the smallest free data block of at least 'req_size' bytes in the
+ * bins, the bin of the request is walked first, then the first non empty
+ * bin above it where every block fits */
+static BlockMetaData *
+mm_free_bins_find_best(FreeBlockBins *free_block_bins, uint32_t req_size) {
+
+    uint32_t fl, sl;
+    uint32_t fl_map, sl_map;
+    BlockMetaData *best_block{nullptr};
+
+    mm_free_bin_mapping(req_size, &fl, &sl);
+    best_block = mm_free_bin_smallest_fit(&free_block_bins->bin_head[fl][sl], req_size);
+    if (best_block) {
+        return best_block;
+    }
+
+    sl_map = free_block_bins->sl_bitmap[fl] & (~0u << (sl + 1));
+    if (sl_map == 0) {
+        fl_map = (fl + 1 < MM_FREE_BIN_FL_COUNT) ? 
+            free_block_bins->fl_bitmap & (~0u << (fl + 1)) : 0;
+        if (fl_map == 0) {
+            return nullptr;
+        }
+        fl = __builtin_ctz(fl_map);
+        sl_map = free_block_bins->sl_bitmap[fl];
+    }
+    sl = __builtin_ctz(sl_map);
+    return mm_free_bin_smallest_fit(&free_block_bins->bin_head[fl][sl], req_size);
+}
+
+
+/* Find the lowest addressed free data block of at least 'req_size' bytes,
+ * so live data packs into the lowest pages and the highest ones empty out */
+static BlockMetaData *
+mm_free_list_find_first(glthread_t *free_list_head, uint32_t req_size) {
+
+    glthread_t *curr{nullptr};
+
+    ITERATE_GLTHREAD_BEGIN(free_list_head, curr) {
+        if (glthread_to_block_meta_data(curr)->block_size >= req_size) {
+            return glthread_to_block_meta_data(curr);
+        }
+    } ITERATE_GLTHREAD_END(free_list_head, curr);
+    return nullptr;
+}
+
+
+/* Add a free data block into the free block index of the family */
+static void 
+mm_add_free_block_meta_data_to_free_block_list(
+        StructureFamily *structure_family,
+        BlockMetaData *free_block) {
+    
+    assert(free_block->is_free == MM_TRUE);
+    assert(free_block->block_size >= MM_MIN_DATA_BLOCK_SIZE);
+    structure_family->counters.free_block_count++;
+    free_block->is_indexed = MM_TRUE;
+    if (mm_free_list_policy_uses_bins(structure_family->free_list_policy)) {
+        mm_free_bins_insert(&structure_family->free_block_bins, free_block);
+        return;
+    }
+    glthread_priority_insert(&structure_family->free_block_priority_list_head,
+                             mm_free_block_glue(free_block),
+                             (structure_family->free_list_policy == MM_FREE_LIST_ADDRESS_ORDERED) ?
+                                mm_free_blocks_address_comparison_function : 
+                                mm_free_blocks_comparison_function,
+                             sizeof(BlockMetaData));
+}
+
+
+/* Remove a free data block from the free block index of the family */
+static void 
+mm_remove_free_block_meta_data_from_free_block_list(
+        StructureFamily *structure_family,
+        BlockMetaData *free_block) {
+
+    /* A block just being freed is not linked into the index yet, its data
+     * block still holds application data so only the flag can tell */
+    if (free_block->is_indexed == MM_FALSE) {
+        return;
+    }
+    structure_family->counters.free_block_count--;
+    free_block->is_indexed = MM_FALSE;
+    if (mm_free_list_policy_uses_bins(structure_family->free_list_policy)) {
+        mm_free_bins_remove(&structure_family->free_block_bins, free_block);
+        return;
+    }
+    remove_glthread(mm_free_block_glue(free_block));
+}
+
+
+/* Find a free data block able to hold 'req_size' bytes in the family */
+static BlockMetaData *
+mm_find_free_block_for_request(
+        StructureFamily *structure_family,
+        uint32_t req_size) {
+
+    BlockMetaData *free_block{nullptr};
+
+    switch (structure_family->free_list_policy) {
+        case MM_FREE_LIST_SEGREGATED_FIT:
+            return mm_free_bins_find(&structure_family->free_block_bins, req_size);
+        case MM_FREE_LIST_BEST_FIT:
+            return mm_free_bins_find_best(&structure_family->free_block_bins, req_size);
+        case MM_FREE_LIST_ADDRESS_ORDERED:
+            return mm_free_list_find_first(
+                &structure_family->free_block_priority_list_head, req_size);
+        default:
+            break;
+    }
+    free_block = mm_get_biggest_free_block_page_family(structure_family);
+    if (free_block == nullptr || free_block->block_size < req_size) {
+        return nullptr;
+    }
+    return free_block;
+}
+
+
+/* Select the free block index of a structure family,
+ * free blocks already in the family are moved to the new index */
+void mm_set_structure_family_free_list_policy(
+        StructureFamily *structure_family, mm_free_list_policy_t policy) {
+
+    PageForApplication *page_for_appln_curr{nullptr};
+    BlockMetaData *block_meta_data_curr{nullptr};
+    std::unique_lock<std::mutex> family_lock = 
+        mm_lock_if_thread_safe(structure_family->family_lock);
+
+    if (structure_family->free_list_policy == policy) {
+        return;
+    }
+    /* Pull every free block out of the old index first */
+    page_for_appln_curr = structure_family->first_page;
+    while (page_for_appln_curr) {
+        block_meta_data_curr = &page_for_appln_curr->block_meta_data;
+        while (block_meta_data_curr) {
+            if (block_meta_data_curr->is_free == MM_TRUE) {
+                mm_remove_free_block_meta_data_from_free_block_list(
+                    structure_family, block_meta_data_curr);
+            }
+            block_meta_data_curr = next_meta_block(block_meta_data_curr);
+        }
+        page_for_appln_curr = page_for_appln_curr->next;
+    }
+
+    structure_family->free_list_policy = policy;
+
+    /* Then rebuild the new index */
+    page_for_appln_curr = structure_family->first_page;
+    while (page_for_appln_curr) {
+        block_meta_data_curr = &page_for_appln_curr->block_meta_data;
+        while (block_meta_data_curr) {
+            if (block_meta_data_curr->is_free == MM_TRUE) {
+                mm_add_free_block_meta_data_to_free_block_list(
+                    structure_family, block_meta_data_curr);
+            }
+            block_meta_data_curr = next_meta_block(block_meta_data_curr);
+        }
+        page_for_appln_curr = page_for_appln_curr->next;
+    }
+}
+
+
+/* Function to mark block_meta_data as being Allocated for 'size'
+ * bytes of application data.
+ * Return true if block allocation succeeds */
+static vm_bool
+mm_split_free_data_block_for_application(
+        StructureFamily *structure_family,
+        BlockMetaData *block_meta_data,
+        uint32_t size) {
+    
+    BlockMetaData *next_block_meta_data = nullptr;
+    /* A data block must be able to hold the glue once it is freed */
+    uint32_t reserved_size = std::max(size, MM_MIN_DATA_BLOCK_SIZE);
+
+    assert(block_meta_data->is_free == MM_TRUE);
+    if (block_meta_data->block_size < reserved_size) {
         return MM_FALSE;
     }
     
-    uint32_t remaining_size = block_meta_data->block_size - size;
+    uint32_t remaining_size = block_meta_data->block_size - reserved_size;
+    uint8_t tail_gap = block_meta_data->tail_gap;
     
+    mm_remove_free_block_meta_data_from_free_block_list(
+        structure_family, block_meta_data);
     block_meta_data->is_free = MM_FALSE;
+    block_meta_data->alignment_log2 = 0;
     block_meta_data->block_size = size;
-    remove_glthread(&block_meta_data->priority_thread_glue);
+    block_meta_data->tail_gap = reserved_size - size;
 
     /*Case 1: No Split*/
     if (remaining_size == 0) {
+        block_meta_data->tail_gap += tail_gap;
         return MM_TRUE;
     }
 
     /*Case 3: Partial Split - Soft Internal Fragmentation*/
-    else if (sizeof(BlockMetaData) < remaining_size && 
+    else if (sizeof(BlockMetaData) + MM_MIN_DATA_BLOCK_SIZE <= remaining_size && 
              remaining_size < sizeof(BlockMetaData) + structure_family->struct_size) {
-        next_block_meta_data = next_meta_block_by_size(block_meta_data);
+        next_block_meta_data = (BlockMetaData *)((char *)(block_meta_data + 1) + reserved_size);
         next_block_meta_data->is_free = MM_TRUE;
+        next_block_meta_data->is_zeroed = block_meta_data->is_zeroed;
+        next_block_meta_data->is_indexed = MM_FALSE;
+        next_block_meta_data->is_cached = MM_FALSE;
+        next_block_meta_data->tail_gap = tail_gap;
         next_block_meta_data->block_size = 
             remaining_size - sizeof(BlockMetaData);
         next_block_meta_data->offset = block_meta_data->offset + 
-            sizeof(BlockMetaData) + block_meta_data->block_size;
-        mm_add_free_block_meta_data_to_free_block_list(
-            structure_family, next_block_meta_data);
+            sizeof(BlockMetaData) + reserved_size;
         mm_bind_blocks_for_allocation(
             block_meta_data, next_block_meta_data);
+        mm_add_free_block_meta_data_to_free_block_list(
+            structure_family, next_block_meta_data);
     }
 
     /*Case 3: Partial Split - Hard Internal Fragmentation*/
-    else if(remaining_size < sizeof(BlockMetaData)) {
-        /*Need do nothing*/
+    else if(remaining_size < sizeof(BlockMetaData) + MM_MIN_DATA_BLOCK_SIZE) {
+        /* The fragment stays behind the data block until it is freed */
+        block_meta_data->tail_gap += remaining_size + tail_gap;
     }
 
     /*Case 2: Full Split - New Meta Block is Created*/
     else {
-        next_block_meta_data = next_meta_block_by_size(block_meta_data);
+        next_block_meta_data = (BlockMetaData *)((char *)(block_meta_data + 1) + reserved_size);
         next_block_meta_data->is_free = MM_TRUE;
+        next_block_meta_data->is_zeroed = block_meta_data->is_zeroed;
+        next_block_meta_data->is_indexed = MM_FALSE;
+        next_block_meta_data->is_cached = MM_FALSE;
+        next_block_meta_data->tail_gap = tail_gap;
         next_block_meta_data->block_size = 
             remaining_size - sizeof(BlockMetaData);
         next_block_meta_data->offset = block_meta_data->offset + 
-            sizeof(BlockMetaData) + block_meta_data->block_size;
-        mm_add_free_block_meta_data_to_free_block_list(
-            structure_family, next_block_meta_data);
+            sizeof(BlockMetaData) + reserved_size;
         mm_bind_blocks_for_allocation(
             block_meta_data, next_block_meta_data);
+        mm_add_free_block_meta_data_to_free_block_list(
+            structure_family, next_block_meta_data);
+    }
+    return MM_TRUE;
+}
+
+
+/* Apply for a new page for application and add the 
+ * free block to the priority queue */
+static PageForApplication *
+mm_family_new_page_add(StructureFamily *structure_family){
+
+    PageForApplication *page_for_appln = 
+        mm_allocate_page_for_application(structure_family);
+
+    if(page_for_appln == nullptr)
+        return nullptr;
+
+    /* The new page is like one free block, add it to the
+     * free block list*/
+    mm_add_free_block_meta_data_to_free_block_list(
+        structure_family, &page_for_appln->block_meta_data);
+
+    return page_for_appln;
+}
+
+
+/* Where a data block of 'size' bytes aligned to 'alignment' starts inside
+ * a free block, the padding in front must be able to stay a free block 
+ * of its own, returns nullptr if the free block is too small */
+static char *
+mm_aligned_data_block_in_free_block(BlockMetaData *free_block, 
+        uint32_t size, uint32_t alignment) {
+
+    char *data_block = (char *)(free_block + 1);
+    char *aligned = (char *)mm_align_up((uintptr_t)data_block, alignment);
+
+    while (aligned != data_block && (uint64_t)(aligned - data_block) < 
+            sizeof(BlockMetaData) + MM_MIN_DATA_BLOCK_SIZE) {
+        aligned += alignment;
+    }
+    if (aligned + std::max(size, MM_MIN_DATA_BLOCK_SIZE) > 
+            data_block + free_block->block_size) {
+        return nullptr;
+    }
+    return aligned;
+}
+
+
+/* Mark 'size' bytes aligned to 'alignment' inside a free block as allocated,
+ * the padding in front stays in the free block index as a smaller free 
+ * block, returns the meta block of the data block */
+static BlockMetaData *
+mm_split_free_data_block_aligned(
+        StructureFamily *structure_family,
+        BlockMetaData *free_block,
+        uint32_t size,
+        uint32_t alignment) {
+
+    BlockMetaData *aligned_block{nullptr};
+    char *aligned = mm_aligned_data_block_in_free_block(free_block, size, alignment);
+
+    if (aligned == nullptr) {
+        return nullptr;
+    }
+    if (aligned == (char *)(free_block + 1)) {
+        if (!mm_split_free_data_block_for_application(structure_family, free_block, size)) {
+            return nullptr;
+        }
+        free_block->alignment_log2 = __builtin_ctz(alignment);
+        return free_block;
+    }
+
+    /* The padding is given back, shrunk in place to end at the new meta block */
+    aligned_block = (BlockMetaData *)aligned - 1;
+    mm_remove_free_block_meta_data_from_free_block_list(structure_family, free_block);
+    aligned_block->is_free = MM_TRUE;
+    aligned_block->is_zeroed = free_block->is_zeroed;
+    aligned_block->is_indexed = MM_FALSE;
+    aligned_block->is_cached = MM_FALSE;
+    aligned_block->tail_gap = free_block->tail_gap;
+    aligned_block->block_size = 
+        (char *)(free_block + 1) + free_block->block_size - aligned;
+    aligned_block->offset = free_block->offset + 
+        (uint32_t)((char *)aligned_block - (char *)free_block);
+    free_block->block_size = (char *)aligned_block - (char *)(free_block + 1);
+    free_block->tail_gap = 0;
+    mm_bind_blocks_for_allocation(free_block, aligned_block);
+    mm_add_free_block_meta_data_to_free_block_list(structure_family, free_block);
+
+    if (!mm_split_free_data_block_for_application(structure_family, aligned_block, size)) {
+        return nullptr;
+    }
+    aligned_block->alignment_log2 = __builtin_ctz(alignment);
+    return aligned_block;
+}
+
+
+/* Check if a data block of 'size' bytes aligned to 'alignment' always fits
+ * in an empty page, bigger requests are served by large page runs */
+static inline vm_bool
+mm_aligned_request_fits_page(uint64_t size, uint32_t alignment) {
+    uint64_t worst_padding = (alignment > 1) ? 
+        alignment + sizeof(BlockMetaData) + MM_MIN_DATA_BLOCK_SIZE : 0;
+    return (size + worst_padding <= mm_max_page_allocatable_memory(1)) ? MM_TRUE : MM_FALSE;
+}
+
+
+/* Called by 'xcalloc' to get the largest data block to 
+ * settle down the new data block inside, the data block
+ * starts on an 'alignment' boundary */
+static BlockMetaData *mm_allocate_free_data_block(
+        StructureFamily *structure_family,
+        uint32_t req_size,
+        uint32_t alignment) {
+
+    PageForApplication *page_for_appln = nullptr;
+    
+    BlockMetaData *free_block_meta_data = 
+        mm_find_free_block_for_request(structure_family, req_size);
+
+    /* The block found may be too small once aligned, one big enough
+     * for the worst padding is asked for then */
+    if (free_block_meta_data && alignment > 1 && 
+            !mm_aligned_data_block_in_free_block(free_block_meta_data, req_size, alignment)) {
+        free_block_meta_data = mm_find_free_block_for_request(structure_family, 
+            req_size + alignment + sizeof(BlockMetaData) + MM_MIN_DATA_BLOCK_SIZE);
+    }
+
+    if (free_block_meta_data == nullptr) {
+        
+        /* Try to add a new page to page family to satisfy the request */
+        page_for_appln = mm_family_new_page_add(structure_family);
+        if (page_for_appln == nullptr) {
+            return nullptr;
+        }
+        free_block_meta_data = &page_for_appln->block_meta_data;
+    }
+
+    /* The free block found can satisfy the request */
+    return mm_split_free_data_block_aligned(structure_family,
+        free_block_meta_data, req_size, alignment);
+}
+
+
+/* Find the specific structure registration through the hashed name index */
+StructureFamily*
+mm_lookup_structure_family_by_name(const std::string &struct_name) {
+    
+    std::unique_lock<std::mutex> registration_lock = 
+        mm_lock_if_thread_safe(structure_family_registration_lock);
+    auto structure_family_iter = structure_family_name_index.find(struct_name);
+
+    if (structure_family_iter == structure_family_name_index.end()) {
+        return nullptr;
+    }
+    return structure_family_iter->second;
+}
+
+
+static BlockMetaData* mm_free_blocks(BlockMetaData *to_be_free_block);
+
+
+/* Word and bit of a slot in the bitmap of the slots owned by the application */
+static inline uint64_t *
+mm_slab_owned_word(PageForApplication *page_for_appln, void *slot, uint64_t *bit) {
+    uint32_t slot_index = ((char *)slot - mm_slab_page_slots(page_for_appln)) / 
+        page_for_appln->structure_family->slab_slot_size;
+    *bit = 1ull << (slot_index % 64);
+    return &page_for_appln->slab_page_data.in_use_bitmap[slot_index / 64];
+}
+
+
+/* Hand a single unit data block held by its family or a cache over to the
+ * application, lock free as the cache paths do not take the family lock */
+static inline void
+mm_hand_out_data_block(void *app_data) {
+
+    PageForApplication *page_for_appln = mm_get_page_from_data_block(app_data);
+    uint64_t *owned_word{nullptr};
+    uint64_t bit{0};
+
+    if (page_for_appln->page_kind == MM_PAGE_SLAB) {
+        owned_word = mm_slab_owned_word(page_for_appln, app_data, &bit);
+        __atomic_fetch_or(owned_word, bit, __ATOMIC_RELAXED);
+    } else if (page_for_appln->page_kind == MM_PAGE_BLOCKS) {
+        ((BlockMetaData *)app_data - 1)->is_cached = MM_FALSE;
+    }
+}
+
+
+/* Take a data block back from the application before it goes to a cache or
+ * to its family, a block free or held by a cache already is a double free,
+ * as is a large page run whose cookie was cleared by an earlier take back */
+static inline void
+mm_take_back_data_block(void *app_data) {
+
+    PageForApplication *page_for_appln = mm_get_page_from_data_block(app_data);
+    BlockMetaData *block_meta_data{nullptr};
+    uint64_t *owned_word{nullptr};
+    uint64_t bit{0};
+    uint32_t page_cookie{0};
+
+    if (page_for_appln->page_kind == MM_PAGE_SLAB) {
+        owned_word = mm_slab_owned_word(page_for_appln, app_data, &bit);
+        if (!(__atomic_fetch_and(owned_word, ~bit, __ATOMIC_RELAXED) & bit)) {
+            std::cerr << "Error: Double free detected" << std::endl;
+            exit(-1);
+        }
+    } else if (page_for_appln->page_kind == MM_PAGE_BLOCKS) {
+        block_meta_data = (BlockMetaData *)app_data - 1;
+        if (block_meta_data->is_free == MM_TRUE || block_meta_data->is_cached == MM_TRUE) {
+            std::cerr << "Error: Double free detected" << std::endl;
+            exit(-1);
+        }
+        block_meta_data->is_cached = MM_TRUE;
+    } else if (page_for_appln->page_kind == MM_PAGE_LARGE) {
+        /* Cleared right here, the same run twice in a batch is caught too */
+        page_cookie = mm_page_cookie(page_for_appln);
+        if (!__atomic_compare_exchange_n(&page_for_appln->page_cookie, &page_cookie, 
+                ~page_cookie, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            std::cerr << "Error: Double free detected" << std::endl;
+            exit(-1);
+        }
+    }
+}
+
+
+/* Carve a single unit out of the family, from a slab page 
+ * in slab mode, with the family lock held */
+static void *
+mm_allocate_single_unit(StructureFamily *structure_family, vm_bool *zeroed) {
+
+    BlockMetaData *block_meta_data{nullptr};
+
+    if (structure_family->slab_mode) {
+        return mm_slab_allocate(structure_family, zeroed);
+    }
+    block_meta_data = mm_allocate_free_data_block(
+        structure_family, structure_family->struct_size, structure_family->alignment);
+    if (block_meta_data == nullptr) {
+        return nullptr;
+    }
+    *zeroed = block_meta_data->is_zeroed;
+    return (char *)(block_meta_data + 1);
+}
+
+
+/* Give a data block back to the page it was carved from,
+ * with the family lock held */
+static void
+mm_free_data_block(void *app_data) {
+
+    PageForApplication *page_for_appln = mm_get_page_from_data_block(app_data);
+
+    if (page_for_appln->page_kind == MM_PAGE_SLAB) {
+        mm_slab_free(page_for_appln, app_data);
+        return;
+    }
+    if (page_for_appln->page_kind == MM_PAGE_LARGE) {
+        mm_delete_and_free_page_for_application(page_for_appln);
+        return;
+    }
+    if (page_for_appln->page_kind == MM_PAGE_REGION) {
+        return; /* Released with the region */
+    }
+    mm_free_blocks(reinterpret_cast<BlockMetaData*>(
+        (char *)app_data - sizeof(BlockMetaData)));
+}
+
+
+/* Push a chain of data blocks, linked through their first word from 
+ * 'first' to 'last', on the remote free stack of the family with a single
+ * CAS, no lock is taken */
+static void
+mm_remote_free_push(StructureFamily *structure_family, void *first, void *last) {
+
+    void *head = structure_family->remote_free_head.load(std::memory_order_relaxed);
+    do {
+        *(void **)last = head;
+    } while (!structure_family->remote_free_head.compare_exchange_weak(
+        head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+
+/* Free every data block pushed on the remote free stack of the family,
+ * with the family lock held, the whole stack is taken at once so a block
+ * pushed again meanwhile can not be confused with the old head */
+static void
+mm_remote_free_drain(StructureFamily *structure_family) {
+
+    if (structure_family->remote_free_head.load(std::memory_order_relaxed) == nullptr) {
+        return;
+    }
+    void *app_data = structure_family->remote_free_head.exchange(
+        nullptr, std::memory_order_acquire);
+    while (app_data) {
+        void *next = *(void **)app_data;
+        mm_free_data_block(app_data);
+        app_data = next;
+    }
+}
+
+
+/* The cache of the CPU the calling thread runs on, a thread moved to
+ * another CPU right after the lookup only costs some locality */
+static CpuCache &
+mm_cpu_cache_current() {
+    int cpu = sched_getcpu();
+    return cpu_caches[(cpu < 0) ? 0 : (uint32_t)cpu % cpu_cache_count];
+}
+
+
+/* The bin of a family in a CPU cache, allocated on first use,
+ * with the CPU cache lock held */
+static CpuCacheBin &
+mm_cpu_cache_bin(CpuCache &cpu_cache, StructureFamily *structure_family) {
+    if (cpu_cache.bins.size() <= structure_family->family_id) {
+        cpu_cache.bins.resize(structure_family->family_id + 1);
+    }
+    std::unique_ptr<CpuCacheBin> &cpu_bin = cpu_cache.bins[structure_family->family_id];
+    if (!cpu_bin) {
+        cpu_bin.reset(new CpuCacheBin(mm_init_options.cpu_cache_capacity));
+    }
+    return *cpu_bin;
+}
+
+
+/* Give the 'count' coldest blocks of a CPU cache bin back to the family, 
+ * with the CPU cache lock held */
+static void
+mm_cpu_cache_flush_bin(StructureFamily *structure_family, 
+        CpuCacheBin &cpu_bin, uint32_t count) {
+
+    std::unique_lock<std::mutex> family_lock = 
+        mm_lock_if_thread_safe(structure_family->family_lock);
+
+    count = std::min(count, cpu_bin.count);
+    for (uint32_t i = 0; i < count; i++) {
+        mm_free_data_block(cpu_bin.data_blocks[i]);
+    }
+    cpu_bin.count -= count;
+    memmove(cpu_bin.data_blocks.get(), cpu_bin.data_blocks.get() + count, 
+        cpu_bin.count * sizeof(void *));
+    memmove(cpu_bin.zeroed.get(), cpu_bin.zeroed.get() + count, 
+        cpu_bin.count * sizeof(vm_bool));
+}
+
+
+/* Refill an empty thread cache bin with a batch of the hottest blocks
+ * of the current CPU cache */
+static void
+mm_cpu_cache_refill_thread_bin(StructureFamily *structure_family, ThreadCacheBin &bin) {
+
+    CpuCache &cpu_cache = mm_cpu_cache_current();
+    std::unique_lock<std::mutex> cpu_lock(cpu_cache.cpu_lock);
+    CpuCacheBin &cpu_bin = mm_cpu_cache_bin(cpu_cache, structure_family);
+
+    while (bin.count < mm_init_options.thread_cache_batch && cpu_bin.count) {
+        cpu_bin.count--;
+        bin.zeroed[bin.count] = cpu_bin.zeroed[cpu_bin.count];
+        bin.data_blocks[bin.count++] = cpu_bin.data_blocks[cpu_bin.count];
+    }
+}
+
+
+/* Move the 'count' most recently cached blocks of a thread cache bin 
+ * to the current CPU cache, its coldest blocks go back to the family
+ * when it runs full */
+static void
+mm_cpu_cache_take_thread_bin(StructureFamily *structure_family, 
+        ThreadCacheBin &bin, uint32_t count) {
+
+    CpuCache &cpu_cache = mm_cpu_cache_current();
+    std::unique_lock<std::mutex> cpu_lock(cpu_cache.cpu_lock);
+    CpuCacheBin &cpu_bin = mm_cpu_cache_bin(cpu_cache, structure_family);
+
+    count = std::min(count, bin.count);
+    if (cpu_bin.count + count > mm_init_options.cpu_cache_capacity) {
+        mm_cpu_cache_flush_bin(structure_family, cpu_bin, 
+            cpu_bin.count + count - mm_init_options.cpu_cache_capacity / 2);
+    }
+    /* The bottom of the moved blocks goes first so the hottest stay on top */
+    memcpy(cpu_bin.data_blocks.get() + cpu_bin.count, bin.data_blocks + bin.count - count, 
+        count * sizeof(void *));
+    memcpy(cpu_bin.zeroed.get() + cpu_bin.count, bin.zeroed + bin.count - count, 
+        count * sizeof(vm_bool));
+    cpu_bin.count += count;
+    bin.count -= count;
+}
+
+
+/* Pop a single unit data block of the family from the calling thread's
+ * cache, refilling the cache with a batch of blocks if it is empty,
+ * from the CPU cache first */
+static void *
+mm_thread_cache_pop(StructureFamily *structure_family, vm_bool *zeroed) {
+
+    void *app_data{nullptr};
+
+    if (thread_cache.bins.size() <= structure_family->family_id) {
+        thread_cache.bins.resize(structure_family->family_id + 1);
+    }
+    ThreadCacheBin &bin = thread_cache.bins[structure_family->family_id];
+
+    if (bin.count == 0 && cpu_cache_count) {
+        mm_cpu_cache_refill_thread_bin(structure_family, bin);
+    }
+    if (bin.count == 0) {
+        /* Refill path, the only place allocation takes the family lock */
+        std::unique_lock<std::mutex> family_lock = 
+            mm_lock_if_thread_safe(structure_family->family_lock);
+        mm_remote_free_drain(structure_family);
+        while (bin.count < mm_init_options.thread_cache_batch) {
+            app_data = mm_allocate_single_unit(structure_family, zeroed);
+            if (app_data == nullptr) {
+                break;
+            }
+            if (!structure_family->slab_mode) {
+                ((BlockMetaData *)app_data - 1)->is_cached = MM_TRUE;
+            }
+            bin.zeroed[bin.count] = *zeroed;
+            bin.data_blocks[bin.count++] = app_data;
+        }
+        if (bin.count == 0) {
+            return nullptr;
+        }
+    }
+    *zeroed = bin.zeroed[--bin.count];
+    return bin.data_blocks[bin.count];
+}
+
+
+/* Give the 'count' most recently cached blocks of a bin back to the 
+ * family, through the CPU cache if there is one */
+static void
+mm_thread_cache_flush_bin(StructureFamily *structure_family, 
+        ThreadCacheBin &bin, uint32_t count) {
+
+    if (cpu_cache_count) {
+        mm_cpu_cache_take_thread_bin(structure_family, bin, count);
+        return;
+    }
+    std::unique_lock<std::mutex> family_lock = 
+        mm_lock_if_thread_safe(structure_family->family_lock);
+
+    while (count-- && bin.count) {
+        mm_free_data_block(bin.data_blocks[--bin.count]);
+    }
+}
+
+
+/* Give the 'count' most recently cached blocks of a bin back to the
+ * family through its remote free stack, chained in the bin order */
+static void
+mm_thread_cache_push_remote(StructureFamily *structure_family, 
+        ThreadCacheBin &bin, uint32_t count) {
+
+    count = std::min(count, bin.count);
+    if (count == 0) {
+        return;
+    }
+    void **chain = bin.data_blocks + bin.count - count;
+    for (uint32_t i = 0; i + 1 < count; i++) {
+        *(void **)chain[i] = chain[i + 1];
+    }
+    mm_remote_free_push(structure_family, chain[0], chain[count - 1]);
+    bin.count -= count;
+}
+
+
+/* Push a freed single unit data block into the calling thread's cache,
+ * flushing a batch back to the family if the cache is full */
+static void
+mm_thread_cache_push(StructureFamily *structure_family, void *app_data) {
+
+    if (thread_cache.bins.size() <= structure_family->family_id) {
+        thread_cache.bins.resize(structure_family->family_id + 1);
+    }
+    ThreadCacheBin &bin = thread_cache.bins[structure_family->family_id];
+
+    if (bin.count == mm_init_options.thread_cache_capacity) {
+        if (mm_init_options.remote_free && !cpu_cache_count) {
+            mm_thread_cache_push_remote(structure_family, bin, 
+                mm_init_options.thread_cache_batch);
+        } else {
+            mm_thread_cache_flush_bin(structure_family, bin, 
+                mm_init_options.thread_cache_batch);
+        }
+    }
+    bin.zeroed[bin.count] = MM_FALSE;
+    bin.data_blocks[bin.count++] = app_data;
+}
+
+
+/* Allocate 'units' of a structure family, the data block is zero filled
+ * only if asked to and not already known to be zero, and starts on the
+ * family alignment or on 'alignment' if bigger */
+static void *
+mm_allocate_data_block(StructureFamily *structure_family, int units, 
+        vm_bool zero_fill, uint32_t alignment = 1) {
+
+    void *app_data{nullptr};
+    vm_bool zeroed = MM_FALSE;
+
+    if (structure_family == nullptr) {
+        std::cerr << "Error: Structure family is not registered in the Memory Manager" << std::endl;
+        return nullptr;
+    }
+
+    if (units <= 0) {
+        std::cerr << "Error: Memory requested must be at least one unit" << std::endl;
+        return nullptr;
+    }
+
+    /* Requests beyond one VM page get their own run of pages */
+    uint64_t req_size = (uint64_t)units * structure_family->struct_size;
+    alignment = std::max(alignment, structure_family->alignment);
+    if (!mm_aligned_request_fits_page(req_size, alignment)) {
+        std::unique_lock<std::mutex> family_lock = 
+            mm_lock_if_thread_safe(structure_family->family_lock);
+        mm_remote_free_drain(structure_family);
+        return mm_large_object_allocate(structure_family, req_size, alignment, zero_fill);
+    }
+
+    /* Single units are served by the thread cache in thread safe mode,
+     * as long as the family alignment is enough */
+    if (units == 1 && alignment == structure_family->alignment) {
+        if (mm_thread_cache_enabled()) {
+            app_data = mm_thread_cache_pop(structure_family, &zeroed);
+        } else {
+            std::unique_lock<std::mutex> family_lock = 
+                mm_lock_if_thread_safe(structure_family->family_lock);
+            app_data = mm_allocate_single_unit(structure_family, &zeroed);
+        }
+        if (app_data == nullptr) {
+            return nullptr;
+        }
+        mm_hand_out_data_block(app_data);
+        if (zero_fill && !zeroed) {
+            memset(app_data, 0, structure_family->struct_size);
+        }
+        return app_data;
+    }
+
+    /* Find the page which can satisfy the request */
+    BlockMetaData *free_block_meta_data = nullptr;
+    {
+        std::unique_lock<std::mutex> family_lock = 
+            mm_lock_if_thread_safe(structure_family->family_lock);
+        mm_remote_free_drain(structure_family);
+        free_block_meta_data = mm_allocate_free_data_block(
+            structure_family, units * structure_family->struct_size, alignment);
+    }
+    
+    if (free_block_meta_data) {
+        /* Fill in with zero */
+        if (zero_fill && !free_block_meta_data->is_zeroed) {
+            memset((char *)(free_block_meta_data + 1), 0, 
+                free_block_meta_data->block_size);
+        }
+        /* Jump to the data block, instead of meta block */
+        return (char *)(free_block_meta_data + 1); 
+    }
+    return nullptr;
+}
+
+
+/* Bytes the application asked for and bytes a data block takes out of 
+ * its family, the meta block and the slot padding included */
+static inline void
+mm_data_block_footprint(PageForApplication *page_for_appln, void *app_data,
+        uint64_t *bytes_requested, uint64_t *bytes_consumed) {
+
+    BlockMetaData *block_meta_data{nullptr};
+
+    switch (page_for_appln->page_kind) {
+        case MM_PAGE_SLAB:
+            *bytes_requested = page_for_appln->structure_family->struct_size;
+            *bytes_consumed = page_for_appln->structure_family->slab_slot_size;
+            break;
+        case MM_PAGE_LARGE:
+            *bytes_requested = page_for_appln->large_page_data.object_size;
+            *bytes_consumed = 
+                (uint64_t)page_for_appln->large_page_data.page_units * SYSTEM_PAGE_SIZE;
+            break;
+        default:
+            block_meta_data = (BlockMetaData *)app_data - 1;
+            *bytes_requested = block_meta_data->block_size;
+            *bytes_consumed = block_meta_data->block_size + sizeof(BlockMetaData);
+            break;
+    }
+}
+
+
+/* Move the live byte counters of a family, tracking the peak */
+static inline void
+mm_stats_account_bytes(FamilyCounters &counters, 
+        int64_t bytes_requested, int64_t bytes_consumed) {
+
+    counters.bytes_requested.fetch_add(bytes_requested, std::memory_order_relaxed);
+    uint64_t consumed = bytes_consumed + counters.bytes_consumed.fetch_add(
+        bytes_consumed, std::memory_order_relaxed);
+
+    uint64_t peak = counters.peak_bytes_consumed.load(std::memory_order_relaxed);
+    while (bytes_consumed > 0 && consumed > peak && 
+        !counters.peak_bytes_consumed.compare_exchange_weak(
+            peak, consumed, std::memory_order_relaxed)) {
+    }
+}
+
+
+/* Count a data block handed to (or given back by) the application */
+static inline void
+mm_stats_account(StructureFamily *structure_family, void *app_data, vm_bool allocated) {
+
+    uint64_t bytes_requested{0}, bytes_consumed{0};
+
+    mm_data_block_footprint(mm_get_page_from_data_block(app_data), app_data,
+        &bytes_requested, &bytes_consumed);
+    if (!allocated) {
+        structure_family->counters.free_count.fetch_add(1, std::memory_order_relaxed);
+        mm_stats_account_bytes(structure_family->counters, 
+            -(int64_t)bytes_requested, -(int64_t)bytes_consumed);
+        return;
+    }
+    structure_family->counters.alloc_count.fetch_add(1, std::memory_order_relaxed);
+    mm_stats_account_bytes(structure_family->counters, bytes_requested, bytes_consumed);
+}
+
+
+/* Public function called by the application for dynamic memory allocation,
+ * the family handle is already resolved so no string work is done here */
+void *xcalloc(StructureFamily *structure_family, int units) {
+    void *app_data = mm_allocate_data_block(structure_family, units, MM_TRUE);
+    if (app_data) {
+        mm_stats_account(structure_family, app_data, MM_TRUE);
+    }
+    return app_data;
+}
+
+
+/* Legacy public function called by the application for dynamic memory allocation */
+void *xcalloc(std::string struct_name, int units) {
+
+    /* Look for structure family by name */
+    StructureFamily *structure_family = mm_lookup_structure_family_by_name(struct_name);
+
+    if (structure_family == nullptr) {
+        std::cerr << "Error: Structure " << struct_name 
+                  << " is not registered in the Memory Manager" << std::endl;
+        return nullptr;
+    }
+    return xcalloc(structure_family, units);
+}
+
+
+/* Zero filled allocation starting on an 'alignment' boundary */
+void *xcalloc_aligned(StructureFamily *structure_family, int units, uint32_t alignment) {
+
+    if (alignment == 0 || (alignment & (alignment - 1)) || alignment > MM_MAX_ALIGNMENT) {
+        std::cerr << "Error: Alignment must be a power of two up to " 
+                  << MM_MAX_ALIGNMENT << std::endl;
+        return nullptr;
+    }
+    void *app_data = mm_allocate_data_block(structure_family, units, MM_TRUE, alignment);
+    if (app_data) {
+        mm_stats_account(structure_family, app_data, MM_TRUE);
+    }
+    return app_data;
+}
+
+
+/* Public function called by the application for dynamic memory allocation
+ * without zero filling, for callers overwriting the memory anyway */
+void *xmalloc(StructureFamily *structure_family, int units) {
+    void *app_data = mm_allocate_data_block(structure_family, units, MM_FALSE);
+    if (app_data) {
+        mm_stats_account(structure_family, app_data, MM_TRUE);
+    }
+    return app_data;
+}
+
+
+/* Legacy public function for allocation without zero filling */
+void *xmalloc(std::string struct_name, int units) {
+
+    StructureFamily *structure_family = mm_lookup_structure_family_by_name(struct_name);
+
+    if (structure_family == nullptr) {
+        std::cerr << "Error: Structure " << struct_name 
+                  << " is not registered in the Memory Manager" << std::endl;
+        return nullptr;
+    }
+    return xmalloc(structure_family, units);
+}
+
+
+/* Family of a size class, registered in slab mode on first use, the
+ * medium one on block pages indexed by segregated fit bins, a page run
+ * one retaining its freed runs, nullptr if the kernel is out of memory
+ * for its registration */
+static StructureFamily *
+mm_size_class_family(uint32_t size_class) {
+
+    StructureFamily *structure_family = 
+        size_class_families[size_class].load(std::memory_order_acquire);
+
+    if (structure_family) {
+        return structure_family;
+    }
+    std::unique_lock<std::mutex> size_class_lock = 
+        mm_lock_if_thread_safe(size_class_registration_lock);
+    structure_family = size_class_families[size_class].load(std::memory_order_relaxed);
+    if (structure_family) {
+        return structure_family;
+    }
+    if (size_class == MM_SIZE_CLASS_MEDIUM) {
+        structure_family = mm_instantiate_new_structure_family(
+            "mm_class_medium", MM_SIZE_CLASS_ALIGNMENT, MM_SIZE_CLASS_ALIGNMENT);
+    } else if (size_class > MM_SIZE_CLASS_MEDIUM) {
+        structure_family = mm_instantiate_new_structure_family(
+            "mm_class_run_" + std::to_string(size_class - MM_SIZE_CLASS_MEDIUM), 
+            MM_SIZE_CLASS_ALIGNMENT, MM_SIZE_CLASS_ALIGNMENT);
+    } else {
+        structure_family = mm_instantiate_new_structure_family(
+            "mm_class_" + std::to_string(mm_size_class_size(size_class)),
+            mm_size_class_size(size_class), MM_SIZE_CLASS_ALIGNMENT);
+    }
+    if (structure_family == nullptr) {
+        return nullptr;
+    }
+    if (size_class == MM_SIZE_CLASS_MEDIUM) {
+        mm_set_structure_family_free_list_policy(structure_family, MM_FREE_LIST_SEGREGATED_FIT);
+    } else if (size_class > MM_SIZE_CLASS_MEDIUM) {
+        std::unique_lock<std::mutex> family_lock = 
+            mm_lock_if_thread_safe(structure_family->family_lock);
+        structure_family->run_page_units = size_class - MM_SIZE_CLASS_MEDIUM;
+    } else {
+        mm_set_structure_family_slab_mode(structure_family, true);
+    }
+    size_class_families[size_class].store(structure_family, std::memory_order_release);
+    return structure_family;
+}
+
+
+/* Allocate 'size' bytes from the smallest size class holding them, 
+ * requests above a quarter of a page from the medium family in 16 byte 
+ * units and bigger ones get a run of pages from the page run size class
+ * of its length, under the medium family past MM_SIZE_CLASS_RUN_PAGES,
+ * the data block starts on 'alignment' if bigger than the class one,
+ * returns nullptr if the kernel is out of memory */
+static void *
+mm_size_class_allocate(size_t size, vm_bool zero_fill, 
+        uint32_t alignment = MM_SIZE_CLASS_ALIGNMENT) {
+
+    void *app_data{nullptr};
+    vm_bool small = (size <= MM_SIZE_CLASS_MAX && size <= SYSTEM_PAGE_SIZE / 4) ? 
+        MM_TRUE : MM_FALSE;
+    uint32_t size_class = small ? mm_size_class_index(size) : MM_SIZE_CLASS_MEDIUM;
+    uint32_t run_page_units{0};
+
+    if (size > MM_SIZE_CLASS_MAX && size <= MM_SIZE_CLASS_RUN_PAGES * SYSTEM_PAGE_SIZE) {
+        run_page_units = mm_large_object_page_units(size, mm_align_up(
+            MM_LARGE_OBJECT_OFFSET, std::max(alignment, MM_SIZE_CLASS_ALIGNMENT)));
+    }
+    if (run_page_units && run_page_units <= MM_SIZE_CLASS_RUN_PAGES) {
+        size_class = mm_size_class_run(run_page_units);
+    }
+    StructureFamily *structure_family = mm_size_class_family(size_class);
+
+    if (structure_family == nullptr) {
+        return nullptr;
+    }
+    if (small) {
+        app_data = mm_allocate_data_block(structure_family, 1, zero_fill, alignment);
+    } else if (size <= MM_SIZE_CLASS_MAX) {
+        app_data = mm_allocate_data_block(structure_family, 
+            (int)((size + MM_SIZE_CLASS_ALIGNMENT - 1) / MM_SIZE_CLASS_ALIGNMENT), 
+            zero_fill, alignment);
+    } else {
+        std::unique_lock<std::mutex> family_lock = 
+            mm_lock_if_thread_safe(structure_family->family_lock);
+        mm_remote_free_drain(structure_family);
+        app_data = mm_large_object_allocate(structure_family, size, 
+            std::max(alignment, MM_SIZE_CLASS_ALIGNMENT), zero_fill);
+    }
+    if (app_data) {
+        mm_stats_account(structure_family, app_data, MM_TRUE);
+    }
+    return app_data;
+}
+
+
+/* Public function called by the application to allocate bytes of any type */
+void *xmalloc(size_t size) {
+    return mm_size_class_allocate(size, MM_FALSE);
+}
+
+
+/* Public function called by the application to allocate zero filled bytes of any type */
+void *xcalloc(size_t size) {
+    return mm_size_class_allocate(size, MM_TRUE);
+}
+
+
+/* Public function called by the application to allocate bytes of any type
+ * starting on an 'alignment' boundary */
+void *xmalloc_aligned(size_t size, uint32_t alignment) {
+
+    if (alignment == 0 || (alignment & (alignment - 1)) || alignment > MM_MAX_ALIGNMENT) {
+        std::cerr << "Error: Alignment must be a power of two up to " 
+                  << MM_MAX_ALIGNMENT << std::endl;
+        return nullptr;
+    }
+    return mm_size_class_allocate(size, MM_FALSE, alignment);
+}
+
+
+/* Check if a pointer is a data block handed out by the memory manager,
+ * only the VM page holding the pointer is read */
+bool mm_is_managed_data_block(const void *app_data) {
+
+    if (app_data == nullptr || SYSTEM_PAGE_SIZE == 0) {
+        return false;
+    }
+    PageForApplication *page_for_appln = 
+        mm_get_page_from_data_block(const_cast<void *>(app_data));
+    return page_for_appln->page_cookie == mm_page_cookie(page_for_appln);
+}
+
+
+/* Bytes of a data block the application may use, at least the size asked
+ * for, 0 for region objects which keep no size */
+size_t mm_usable_size(void *app_data) {
+
+    PageForApplication *page_for_appln = mm_get_page_from_data_block(app_data);
+
+    switch (page_for_appln->page_kind) {
+        case MM_PAGE_SLAB:
+            return page_for_appln->structure_family->struct_size;
+        case MM_PAGE_LARGE:
+            return (size_t)page_for_appln->large_page_data.page_units * SYSTEM_PAGE_SIZE - 
+                page_for_appln->large_page_data.object_offset;
+        case MM_PAGE_REGION:
+            return 0;
+        default:
+            return ((BlockMetaData *)app_data - 1)->block_size;
+    }
+}
+
+
+/* Alignment a data block was asked to start on, at least the one of its
+ * family, a large object keeps it in its offset from the page */
+static uint32_t
+mm_data_block_alignment(PageForApplication *page_for_appln, void *app_data) {
+
+    uint32_t alignment = page_for_appln->structure_family->alignment;
+    uint32_t object_offset{0};
+
+    switch (page_for_appln->page_kind) {
+        case MM_PAGE_LARGE:
+            object_offset = page_for_appln->large_page_data.object_offset;
+            return std::max(alignment, std::min(object_offset & -object_offset, MM_MAX_ALIGNMENT));
+        case MM_PAGE_BLOCKS:
+            return std::max(alignment, 1u << ((BlockMetaData *)app_data - 1)->alignment_log2);
+        default:
+            return alignment;
+    }
+}
+
+
+/* Union two free data blocks, both are taken out of the free block
+ * index before the sizes change */
+static void
+mm_union_free_blocks(StructureFamily *structure_family,
+        BlockMetaData *first, BlockMetaData *second){
+
+    assert(first->is_free == MM_TRUE &&
+        second->is_free == MM_TRUE);
+
+    mm_remove_free_block_meta_data_from_free_block_list(structure_family, first);
+    mm_remove_free_block_meta_data_from_free_block_list(structure_family, second);
+
+    first->block_size += sizeof(BlockMetaData) +
+            second->block_size;
+    first->is_zeroed = MM_FALSE; /* The meta block of 'second' is data now */
+
+    mm_bind_blocks_for_deallocation(first, second);
+}
+
+
+/* Called by xfree to release the memory used by some application data */
+static BlockMetaData*
+mm_free_blocks(BlockMetaData *to_be_free_block) {
+
+    BlockMetaData *return_block{nullptr};
+
+    /* Get the page for application where the 'to_be_free_block' lies */
+    assert(to_be_free_block->is_free == MM_FALSE);
+    PageForApplication *hosting_page = 
+        reinterpret_cast<PageForApplication*>(mm_get_page_from_meta_block(to_be_free_block));
+    
+    /* Get the page family back */
+    StructureFamily *structure_family = hosting_page->structure_family;
+
+    /* Free the target meta block, and check different situations */
+    return_block = to_be_free_block;
+    to_be_free_block->is_free = MM_TRUE;
+    to_be_free_block->is_zeroed = MM_FALSE;
+    to_be_free_block->is_cached = MM_FALSE;
+
+    BlockMetaData *next_block = next_meta_block(to_be_free_block);
+
+    /* The hard internal fragment behind the data block, up to the next
+     * meta block or to the uppermost top of the page, is given back */
+    to_be_free_block->block_size += to_be_free_block->tail_gap;
+    to_be_free_block->tail_gap = 0;
+
+    /* Merging process, merge the free blocks above and beneath */
+    if (next_block && next_block->is_free == MM_TRUE) {
+        /* Union two free blocks */
+        mm_union_free_blocks(structure_family, to_be_free_block, next_block);
+        return_block = to_be_free_block;
+    }
+    BlockMetaData *prev_block = prev_meta_block(to_be_free_block);
+    if (prev_block && prev_block->is_free == MM_TRUE) {
+        mm_union_free_blocks(structure_family, prev_block, to_be_free_block);
+        return_block = prev_block;
+    }
+
+    /* If the page for application is empty, release the page back to kernal */
+    if (mm_is_page_for_appln_empty(hosting_page)) {
+        mm_delete_and_free_page_for_application(hosting_page);
+        return nullptr;
+    }
+
+    /* Add the big empty data block to the priority queue */
+    mm_add_free_block_meta_data_to_free_block_list(
+        structure_family, return_block);
+
+    return return_block;
+}
+
+
+/* The API for application call to free application data block */
+void xfree(void *app_data) {
+
+    PageForApplication *page_for_appln = mm_get_page_from_data_block(app_data);
+    StructureFamily *structure_family = page_for_appln->structure_family;
+    vm_bool single_unit = (page_for_appln->page_kind == MM_PAGE_LARGE) ? MM_FALSE : MM_TRUE;
+
+    /* Region objects are released with their region */
+    if (page_for_appln->page_kind == MM_PAGE_REGION) {
+        return;
+    }
+
+    if (page_for_appln->page_kind == MM_PAGE_BLOCKS) {
+        /*Get the guardian meta block of current data block by subtracting the size of Meta Block*/
+        BlockMetaData *block_meta_data = 
+            reinterpret_cast<BlockMetaData*>((char *)app_data - sizeof(BlockMetaData));
+        single_unit = (block_meta_data->block_size == structure_family->struct_size) ? 
+            MM_TRUE : MM_FALSE;
+    }
+    /* Catch a double free before the block reaches a cache or the family */
+    mm_take_back_data_block(app_data);
+    mm_stats_account(structure_family, app_data, MM_FALSE);
+
+    /* Single units go back to the thread cache in thread safe mode */
+    if (single_unit && mm_thread_cache_enabled()) {
+        mm_thread_cache_push(structure_family, app_data);
+        return;
+    }
+
+    /* Multi unit blocks go on the remote free stack of the family, freed 
+     * by the next allocation that takes the family lock, a large page run
+     * is unmapped at once so its memory is not held until then */
+    if (mm_init_options.thread_safe && mm_init_options.remote_free && 
+            page_for_appln->page_kind != MM_PAGE_LARGE) {
+        mm_remote_free_push(structure_family, app_data, app_data);
+        return;
+    }
+
+    std::unique_lock<std::mutex> family_lock = 
+        mm_lock_if_thread_safe(structure_family->family_lock);
+    mm_free_data_block(app_data);
+}
+
+
+/* Get a page (or a run of 'page_units' pages for a large object) for a 
+ * region, single pages come from the global page cache first, nullptr
+ * if the kernel is out of memory */
+static PageForApplication *
+mm_region_new_page(MmRegion *region, uint32_t page_units) {
+
+    vm_bool zeroed = MM_FALSE;
+    int numa_node = mm_numa_node_for(nullptr);
+    void *vm_page = (page_units == 1) ? mm_page_cache_get(nullptr, &zeroed, numa_node) : nullptr;
+
+    if (vm_page == nullptr) {
+        vm_page = mm_get_vm_page_for_appln(page_units, &zeroed, numa_node);
+    }
+    if (vm_page == nullptr) {
+        return nullptr;
+    }
+    PageForApplication *page_for_appln = static_cast<PageForApplication*>(vm_page);
+    page_for_appln->structure_family = nullptr;
+    page_for_appln->page_kind = MM_PAGE_REGION;
+    page_for_appln->numa_node = numa_node;
+    page_for_appln->page_cookie = mm_page_cookie(page_for_appln);
+    numa_pool_page_count[mm_numa_pool(numa_node)].fetch_add(page_units, std::memory_order_relaxed);
+    page_for_appln->prev = nullptr;
+    page_for_appln->next = nullptr;
+    page_for_appln->region_page_data.region = region;
+    page_for_appln->region_page_data.page_units = page_units;
+    page_for_appln->region_page_data.bump_offset = MM_REGION_OBJECT_OFFSET;
+    page_for_appln->region_page_data.bump_zeroed = zeroed;
+    region_page_count.fetch_add(page_units, std::memory_order_relaxed);
+    if (region) {
+        region->page_count += page_units;
+    }
+    return page_for_appln;
+}
+
+
+/* Create a region, it lives in its first page */
+MmRegion *mm_region_create() {
+
+    PageForApplication *page_for_appln = mm_region_new_page(nullptr, 1);
+    if (page_for_appln == nullptr) {
+        return nullptr;
+    }
+    MmRegion *region = new ((char *)page_for_appln + MM_REGION_OBJECT_OFFSET) MmRegion();
+
+    page_for_appln->region_page_data.region = region;
+    page_for_appln->region_page_data.bump_offset += (sizeof(MmRegion) + 15) & ~(size_t)15;
+    region->first_page = page_for_appln;
+    region->page_count = 1;
+    region_count.fetch_add(1, std::memory_order_relaxed);
+    return region;
+}
+
+
+/* Give every page of the region back, the page holding the region included */
+void mm_region_destroy(MmRegion *region) {
+
+    PageForApplication *page_for_appln{nullptr};
+    PageForApplication *next_page{nullptr};
+    uint32_t page_units{0};
+
+    if (region == nullptr) {
+        return;
+    }
+    page_for_appln = region->first_page;
+    while (page_for_appln) {
+        next_page = page_for_appln->next;
+        page_units = page_for_appln->region_page_data.page_units;
+        region_page_count.fetch_sub(page_units, std::memory_order_relaxed);
+        numa_pool_page_count[mm_numa_pool(page_for_appln->numa_node)].fetch_sub(
+            page_units, std::memory_order_relaxed);
+        page_for_appln->page_cookie = ~mm_page_cookie(page_for_appln);
+        if (page_units != 1 || !mm_page_cache_put(nullptr, page_for_appln)) {
+            mm_return_vm_page_for_appln(page_for_appln, page_units);
+        }
+        page_for_appln = next_page;
+    }
+    region_count.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+/* Bump 'units' of a structure family out of the current page of a region,
+ * a full page is left as it is and a new one becomes current, an object
+ * too big for a page gets a page run of its own */
+static void *
+mm_region_allocate(MmRegion *region, StructureFamily *structure_family, 
+        int units, vm_bool zero_fill) {
+
+    PageForApplication *page_for_appln{nullptr};
+    void *app_data{nullptr};
+
+    if (region == nullptr || structure_family == nullptr) {
+        std::cerr << "Error: Region or structure family is not valid" << std::endl;
+        return nullptr;
+    }
+    if (units <= 0) {
+        std::cerr << "Error: Memory requested must be at least one unit" << std::endl;
+        return nullptr;
+    }
+    uint64_t size = mm_align_up((uint64_t)units * structure_family->struct_size, 16);
+    uint64_t alignment = std::max<uint64_t>(structure_family->alignment, 16);
+    uint64_t first_offset = mm_align_up(MM_REGION_OBJECT_OFFSET, alignment);
+    uint64_t offset{0};
+
+    if (first_offset + size > SYSTEM_PAGE_SIZE) {
+        page_for_appln = mm_region_new_page(region, 
+            (first_offset + size + SYSTEM_PAGE_SIZE - 1) / SYSTEM_PAGE_SIZE);
+        if (page_for_appln == nullptr) {
+            return nullptr;
+        }
+        offset = first_offset;
+        /* The current page stays at the head */
+        page_for_appln->next = region->first_page->next;
+        region->first_page->next = page_for_appln;
+    } else {
+        page_for_appln = region->first_page;
+        offset = mm_align_up(page_for_appln->region_page_data.bump_offset, alignment);
+        if (offset + size > SYSTEM_PAGE_SIZE) {
+            page_for_appln = mm_region_new_page(region, 1);
+            if (page_for_appln == nullptr) {
+                return nullptr;
+            }
+            offset = first_offset;
+            page_for_appln->next = region->first_page;
+            region->first_page = page_for_appln;
+        }
+    }
+    app_data = (char *)page_for_appln + offset;
+    page_for_appln->region_page_data.bump_offset = offset + size;
+    region->bytes_allocated += size;
+
+    if (zero_fill && !page_for_appln->region_page_data.bump_zeroed) {
+        memset(app_data, 0, (uint64_t)units * structure_family->struct_size);
+    }
+    return app_data;
+}
+
+
+/* Allocate zero filled 'units' of a structure family from a region */
+void *xcalloc_region(MmRegion *region, StructureFamily *structure_family, int units) {
+    return mm_region_allocate(region, structure_family, units, MM_TRUE);
+}
+
+
+/* Allocate 'units' of a structure family from a region without zero filling */
+void *xmalloc_region(MmRegion *region, StructureFamily *structure_family, int units) {
+    return mm_region_allocate(region, structure_family, units, MM_FALSE);
+}
+
+
+/* Resize an allocated block to 'new_size' bytes inside its page, a free
+ * block above is merged first and the room left above the new size goes 
+ * back to the free block index, returns false if the page has no room,
+ * with the family lock held */
+static vm_bool
+mm_resize_block_in_place(StructureFamily *structure_family,
+        BlockMetaData *block_meta_data, uint32_t new_size) {
+
+    PageForApplication *hosting_page = 
+        reinterpret_cast<PageForApplication*>(mm_get_page_from_meta_block(block_meta_data));
+    BlockMetaData *next_block = next_meta_block(block_meta_data);
+    BlockMetaData *free_block{nullptr};
+    char *limit{nullptr};
+
+    /* Room up to the next allocated block, or to the top of the page */
+    if (next_block && next_block->is_free == MM_TRUE) {
+        limit = next_meta_block(next_block) ? (char *)next_meta_block(next_block) :
+            (char *)hosting_page + SYSTEM_PAGE_SIZE;
+    } else {
+        limit = next_block ? (char *)next_block : (char *)hosting_page + SYSTEM_PAGE_SIZE;
+    }
+    uint32_t reserved_size = std::max(new_size, MM_MIN_DATA_BLOCK_SIZE);
+    if ((char *)(block_meta_data + 1) + reserved_size > limit) {
+        return MM_FALSE;
+    }
+
+    if (next_block && next_block->is_free == MM_TRUE) {
+        mm_remove_free_block_meta_data_from_free_block_list(structure_family, next_block);
+    }
+    block_meta_data->block_size = new_size;
+    block_meta_data->tail_gap = limit - (char *)next_meta_block_by_size(block_meta_data);
+
+    /* What is left above becomes a free block, as in a split, or stays 
+     * a hard internal fragment if it cannot hold a meta block */
+    uint32_t remaining_size = limit - ((char *)(block_meta_data + 1) + reserved_size);
+    if (remaining_size >= sizeof(BlockMetaData) + MM_MIN_DATA_BLOCK_SIZE) {
+        block_meta_data->tail_gap = reserved_size - new_size;
+        free_block = (BlockMetaData *)((char *)(block_meta_data + 1) + reserved_size);
+        free_block->is_free = MM_TRUE;
+        free_block->is_zeroed = MM_FALSE;
+        free_block->is_indexed = MM_FALSE;
+        free_block->is_cached = MM_FALSE;
+        free_block->tail_gap = 0;
+        free_block->block_size = remaining_size - sizeof(BlockMetaData);
+        free_block->offset = block_meta_data->offset + 
+            sizeof(BlockMetaData) + reserved_size;
+        mm_bind_blocks_for_allocation(block_meta_data, free_block);
+        mm_add_free_block_meta_data_to_free_block_list(structure_family, free_block);
+    } else if (next_meta_block(block_meta_data)) {
+        next_meta_block(block_meta_data)->prev_offset = block_meta_data->offset;
+    }
+    return MM_TRUE;
+}
+
+
+/* Resize the object of a large page run to 'new_size' bytes, the run is
+ * remapped if its page count changes, the kernel moves the pages without
+ * copying, returns the object or nullptr, with the family lock held */
+static void *
+mm_resize_large_object(PageForApplication *page_for_appln, uint64_t new_size) {
+
+    StructureFamily *structure_family = page_for_appln->structure_family;
+    uint32_t page_units = page_for_appln->large_page_data.page_units;
+    uint32_t new_page_units = mm_large_object_page_units(new_size, 
+        page_for_appln->large_page_data.object_offset);
+    void *remapped{nullptr};
+
+    /* Only runs mapped on their own can be remapped, a single page
+     * belongs to an arena or came from the page caches */
+    if (new_page_units != page_units && (page_units == 1 || new_page_units == 1)) {
+        return nullptr;
+    }
+    if ((page_for_appln->large_page_data.object_offset + new_size) / SYSTEM_PAGE_SIZE >= 
+            (uint64_t)INT32_MAX) {
+        return nullptr;
+    }
+    if (new_page_units != page_units) {
+        remapped = mremap(page_for_appln, (size_t)page_units * SYSTEM_PAGE_SIZE,
+            (size_t)new_page_units * SYSTEM_PAGE_SIZE, MREMAP_MAYMOVE);
+        if (remapped == MAP_FAILED) {
+            return nullptr;
+        }
+        structure_family->counters.page_count += new_page_units;
+        structure_family->counters.page_count -= page_units;
+        page_for_appln = static_cast<PageForApplication*>(remapped);
+        page_for_appln->large_page_data.page_units = new_page_units;
+        page_for_appln->page_cookie = mm_page_cookie(page_for_appln);
+
+        /* The run may have moved, the neighbours in the family list follow it */
+        if (page_for_appln->prev) {
+            page_for_appln->prev->next = page_for_appln;
+        } else {
+            structure_family->first_large_page = page_for_appln;
+        }
+        if (page_for_appln->next) {
+            page_for_appln->next->prev = page_for_appln;
+        }
+    }
+    page_for_appln->large_page_data.object_size = new_size;
+    return mm_large_page_object(page_for_appln);
+}
+
+
+/* Resize a data block to 'units' of its structure family, in place when 
+ * its page (or page run) has room, moved otherwise, the memory grown
+ * is zero filled, the data block is left untouched on failure */
+void *xrealloc(void *app_data, int units) {
+
+    uint64_t old_requested{0}, old_consumed{0};
+    uint64_t new_requested{0}, new_consumed{0};
+    uint64_t zero_fill_end{0};
+    void *new_app_data{nullptr};
+
+    if (app_data == nullptr) {
+        std::cerr << "Error: Cannot tell the structure family of a null data block" << std::endl;
+        return nullptr;
+    }
+    if (units <= 0) {
+        std::cerr << "Error: Memory requested must be at least one unit" << std::endl;
+        return nullptr;
+    }
+
+    PageForApplication *page_for_appln = mm_get_page_from_data_block(app_data);
+    StructureFamily *structure_family = page_for_appln->structure_family;
+
+    /* Region objects keep no size to resize from */
+    if (page_for_appln->page_kind == MM_PAGE_REGION) {
+        std::cerr << "Error: Region objects cannot be resized" << std::endl;
+        return nullptr;
+    }
+    uint64_t new_size = (uint64_t)units * structure_family->struct_size;
+    vm_bool large = mm_aligned_request_fits_page(new_size, structure_family->alignment) ? 
+        MM_FALSE : MM_TRUE;
+
+    mm_data_block_footprint(page_for_appln, app_data, &old_requested, &old_consumed);
+    if (page_for_appln->page_kind == MM_PAGE_BLOCKS && 
+            (((BlockMetaData *)app_data - 1)->is_free == MM_TRUE || 
+             ((BlockMetaData *)app_data - 1)->is_cached == MM_TRUE)) {
+        std::cerr << "Error: Resizing a freed data block" << std::endl;
+        exit(-1);
+    }
+    if (new_size == old_requested) {
+        return app_data;
+    }
+
+    /* A block stays in its kind of page, a slot never changes size */
+    {
+        std::unique_lock<std::mutex> family_lock = 
+            mm_lock_if_thread_safe(structure_family->family_lock);
+        zero_fill_end = new_size;
+        if (page_for_appln->page_kind == MM_PAGE_BLOCKS && !large &&
+                mm_resize_block_in_place(structure_family, 
+                    (BlockMetaData *)app_data - 1, new_size)) {
+            new_app_data = app_data;
+        } else if (page_for_appln->page_kind == MM_PAGE_LARGE && large) {
+            /* Pages added by mremap are zero filled already */
+            zero_fill_end = std::min<uint64_t>(new_size, 
+                old_consumed - page_for_appln->large_page_data.object_offset);
+            new_app_data = mm_resize_large_object(page_for_appln, new_size);
+        }
+        if (new_app_data) {
+            mm_data_block_footprint(mm_get_page_from_data_block(new_app_data), new_app_data,
+                &new_requested, &new_consumed);
+            mm_stats_account_bytes(structure_family->counters, 
+                (int64_t)new_requested - (int64_t)old_requested,
+                (int64_t)new_consumed - (int64_t)old_consumed);
+        }
     }
-    return MM_TRUE;
+
+    /* A moved block keeps the alignment it was allocated with */
+    if (new_app_data == nullptr) {
+        zero_fill_end = new_size;
+        new_app_data = mm_allocate_data_block(structure_family, units, MM_FALSE, 
+            mm_data_block_alignment(page_for_appln, app_data));
+        if (new_app_data == nullptr) {
+            return nullptr;
+        }
+        mm_stats_account(structure_family, new_app_data, MM_TRUE);
+        memcpy(new_app_data, app_data, std::min<uint64_t>(old_requested, new_size));
+        xfree(app_data);
+    }
+    if (zero_fill_end > old_requested) {
+        memset((char *)new_app_data + old_requested, 0, zero_fill_end - old_requested);
+    }
+    return new_app_data;
 }
 
 
-/* Apply for a new page for application and add the 
- * free block to the priority queue */
-static PageForApplication *
-mm_family_new_page_add(StructureFamily *structure_family){
+/* Distance between two data blocks of 'size' bytes carved back to back */
+static inline uint32_t
+mm_carve_stride(uint32_t size) {
+    return sizeof(BlockMetaData) + std::max(size, MM_MIN_DATA_BLOCK_SIZE);
+}
 
-    PageForApplication *page_for_appln = 
-        mm_allocate_page_for_application(structure_family);
 
-    if(page_for_appln == nullptr)
-        return nullptr;
+/* Carve up to 'count' blocks of 'size' bytes out of one free block in a
+ * single pass, the free block leaves the index once and what is left 
+ * above the last block goes back once, returns the number of blocks
+ * carved, with the family lock held */
+static uint32_t
+mm_carve_free_data_block(StructureFamily *structure_family,
+        BlockMetaData *free_block, uint32_t size, uint32_t count, void **app_data_array) {
 
-    /* The new page is like one free block, add it to the
-     * free block list*/
-    mm_add_free_block_meta_data_to_free_block_list(
-        structure_family, &page_for_appln->block_meta_data);
+    PageForApplication *hosting_page = 
+        reinterpret_cast<PageForApplication*>(mm_get_page_from_meta_block(free_block));
+    BlockMetaData *next_block = next_meta_block(free_block);
+    BlockMetaData *block_meta_data{nullptr};
+    char *limit = next_block ? (char *)next_block : (char *)hosting_page + SYSTEM_PAGE_SIZE;
+    uint32_t stride = mm_carve_stride(size);
+    uint32_t carved = std::min<uint64_t>(count, (limit - (char *)free_block) / stride);
+    uint32_t prev_offset = free_block->prev_offset;
+    vm_bool zeroed = free_block->is_zeroed;
+
+    mm_remove_free_block_meta_data_from_free_block_list(structure_family, free_block);
+
+    for (uint32_t i = 0; i < carved; i++) {
+        block_meta_data = (BlockMetaData *)((char *)free_block + i * stride);
+        block_meta_data->is_free = MM_FALSE;
+        block_meta_data->is_zeroed = zeroed;
+        block_meta_data->is_indexed = MM_FALSE;
+        block_meta_data->is_cached = MM_FALSE;
+        block_meta_data->alignment_log2 = 0;
+        block_meta_data->block_size = size;
+        block_meta_data->tail_gap = stride - sizeof(BlockMetaData) - size;
+        block_meta_data->offset = free_block->offset + i * stride;
+        block_meta_data->prev_offset = prev_offset;
+        prev_offset = block_meta_data->offset;
+        app_data_array[i] = block_meta_data + 1;
+    }
 
-    return page_for_appln;
+    /* The rest becomes a free block as in a split, or a hard internal fragment */
+    uint32_t remaining_size = limit - ((char *)block_meta_data + stride);
+    if (remaining_size >= sizeof(BlockMetaData) + MM_MIN_DATA_BLOCK_SIZE) {
+        block_meta_data = (BlockMetaData *)((char *)block_meta_data + stride);
+        block_meta_data->is_free = MM_TRUE;
+        block_meta_data->is_zeroed = zeroed;
+        block_meta_data->is_indexed = MM_FALSE;
+        block_meta_data->is_cached = MM_FALSE;
+        block_meta_data->tail_gap = 0;
+        block_meta_data->block_size = remaining_size - sizeof(BlockMetaData);
+        block_meta_data->offset = prev_offset + stride;
+        block_meta_data->prev_offset = prev_offset;
+        mm_add_free_block_meta_data_to_free_block_list(structure_family, block_meta_data);
+    } else {
+        block_meta_data->tail_gap += remaining_size;
+    }
+    if (next_block) {
+        next_block->prev_offset = block_meta_data->offset;
+    }
+    return carved;
 }
 
 
-/* Called by 'xcalloc' to get the largest data block to 
- * settle down the new data block inside */
-static BlockMetaData *mm_allocate_free_data_block(
-        StructureFamily *structure_family,
-        uint32_t req_size) {
-
-    vm_bool status = MM_FALSE;
-    PageForApplication *page_for_appln = nullptr;
-    
-    BlockMetaData *biggest_block_meta_data = 
-        mm_get_biggest_free_block_page_family(structure_family);
+/* Allocate 'count' data blocks of 'units' each under a single family lock,
+ * blocks are carved from one free block (or page) at a time, the data 
+ * blocks are stored in 'app_data_array' and zero filled, returns the 
+ * number of data blocks allocated */
+int xcalloc_batch(StructureFamily *structure_family, int units, int count, void **app_data_array) {
 
-    if (biggest_block_meta_data == nullptr || 
-            biggest_block_meta_data->block_size < req_size) {
-        
-        /* Try to add a new page to page family to satisfy the request */
-        page_for_appln = mm_family_new_page_add(structure_family);
+    BlockMetaData *free_block{nullptr};
+    BlockMetaData *block_meta_data{nullptr};
+    PageForApplication *page_for_appln{nullptr};
+    vm_bool zeroed = MM_FALSE;
+    uint32_t allocated{0};
+    uint64_t bytes_requested{0}, bytes_consumed{0};
+    uint64_t block_requested{0}, block_consumed{0};
 
-        /* Allocate the free block from this page new */
-        status = mm_split_free_data_block_for_application(structure_family,
-                    &page_for_appln->block_meta_data, req_size);
-        if (status) {
-            return &page_for_appln->block_meta_data;
+    if (structure_family == nullptr) {
+        std::cerr << "Error: Structure family is not registered in the Memory Manager" << std::endl;
+        return 0;
+    }
+    if (units <= 0 || count < 0) {
+        std::cerr << "Error: Memory requested must be at least one unit" << std::endl;
+        return 0;
+    }
+    uint64_t req_size = (uint64_t)units * structure_family->struct_size;
+    uint32_t alignment = structure_family->alignment;
+    /* Blocks carved back to back stay aligned if the stride is aligned */
+    vm_bool carve_aligned = (mm_carve_stride(req_size) % alignment == 0) ? 
+        MM_TRUE : MM_FALSE;
+
+    {
+        std::unique_lock<std::mutex> family_lock = 
+            mm_lock_if_thread_safe(structure_family->family_lock);
+        mm_remote_free_drain(structure_family);
+
+        while (allocated < (uint32_t)count) {
+            if (!mm_aligned_request_fits_page(req_size, alignment)) {
+                app_data_array[allocated] = 
+                    mm_large_object_allocate(structure_family, req_size, alignment, MM_TRUE);
+                if (app_data_array[allocated] == nullptr) {
+                    break;
+                }
+                allocated++;
+                continue;
+            }
+            if (units == 1 && structure_family->slab_mode) {
+                app_data_array[allocated] = mm_slab_allocate(structure_family, &zeroed);
+                if (app_data_array[allocated] == nullptr) {
+                    break;
+                }
+                mm_hand_out_data_block(app_data_array[allocated]);
+                if (!zeroed) {
+                    memset(app_data_array[allocated], 0, req_size);
+                }
+                allocated++;
+                continue;
+            }
+            free_block = mm_find_free_block_for_request(structure_family, req_size);
+            if (free_block == nullptr) {
+                page_for_appln = mm_family_new_page_add(structure_family);
+                if (page_for_appln == nullptr) {
+                    break;
+                }
+                free_block = &page_for_appln->block_meta_data;
+            }
+            /* One aligned block at a time until a carve can stay aligned */
+            if (!carve_aligned || ((uintptr_t)(free_block + 1) & (alignment - 1))) {
+                block_meta_data = mm_allocate_free_data_block(
+                    structure_family, req_size, alignment);
+                if (block_meta_data == nullptr) {
+                    break;
+                }
+                app_data_array[allocated++] = block_meta_data + 1;
+                continue;
+            }
+            allocated += mm_carve_free_data_block(structure_family, free_block, 
+                req_size, count - allocated, app_data_array + allocated);
         }
-        return nullptr;
     }
 
-    /*T he biggest block meta data can satisfy the request */
-    if (biggest_block_meta_data) {
-        status = mm_split_free_data_block_for_application(structure_family,
-                    biggest_block_meta_data, req_size);
-    }
-    if (status) {
-        return biggest_block_meta_data;
+    /* Zero filled and counted outside of the family lock */
+    for (uint32_t i = 0; i < allocated; i++) {
+        PageForApplication *hosting_page = mm_get_page_from_data_block(app_data_array[i]);
+        if (hosting_page->page_kind == MM_PAGE_BLOCKS && 
+                !((BlockMetaData *)app_data_array[i] - 1)->is_zeroed) {
+            memset(app_data_array[i], 0, req_size);
+        }
+        mm_data_block_footprint(hosting_page, app_data_array[i], 
+            &block_requested, &block_consumed);
+        bytes_requested += block_requested;
+        bytes_consumed += block_consumed;
     }
-    return nullptr;
+    structure_family->counters.alloc_count.fetch_add(allocated, std::memory_order_relaxed);
+    mm_stats_account_bytes(structure_family->counters, bytes_requested, bytes_consumed);
+    return allocated;
 }
 
 
-/* Iterate over all page for structure families 
- * and find the specific structure registration */
-StructureFamily*
-mm_lookup_structure_family_by_name(std::string struct_name) {
-    
-    StructureFamily *structure_family_curr;
-    PageForStructFamilies *page_for_families_curr = first_vm_page_for_families;
-
-    /* Iterate over all page for structure families 
-     * and find the specific structure registration */
-    while(page_for_families_curr != nullptr) {
-        for (auto &page_family: page_for_families_curr->structure_family) {
-            if (page_family.struct_name == struct_name) {
-                structure_family_curr = &page_family;
-                return structure_family_curr;
-            }
+/* Free the data blocks of one block page given all at once: every block is
+ * marked free first, then the page is coalesced in a single pass, with the
+ * family lock held */
+static void
+mm_free_blocks_of_page(StructureFamily *structure_family,
+        PageForApplication *page_for_appln, void **app_data_array, int count) {
+
+    BlockMetaData *block_meta_data{nullptr};
+    BlockMetaData *next_block{nullptr};
+    char *limit{nullptr};
+
+    for (int i = 0; i < count; i++) {
+        block_meta_data = (BlockMetaData *)app_data_array[i] - 1;
+        block_meta_data->is_free = MM_TRUE;
+        block_meta_data->is_zeroed = MM_FALSE;
+        block_meta_data->is_cached = MM_FALSE;
+    }
+
+    /* Each run of free blocks is merged into its first block, with the hard
+     * internal fragments behind them, and indexed once */
+    block_meta_data = &page_for_appln->block_meta_data;
+    while (block_meta_data) {
+        next_block = next_meta_block(block_meta_data);
+        if (block_meta_data->is_free == MM_FALSE) {
+            block_meta_data = next_block;
+            continue;
+        }
+        mm_remove_free_block_meta_data_from_free_block_list(structure_family, block_meta_data);
+        while (next_block && next_block->is_free == MM_TRUE) {
+            mm_remove_free_block_meta_data_from_free_block_list(structure_family, next_block);
+            next_block = next_meta_block(next_block);
         }
-        page_for_families_curr = page_for_families_curr->next;
+        limit = next_block ? (char *)next_block : (char *)page_for_appln + SYSTEM_PAGE_SIZE;
+        if ((char *)(block_meta_data + 1) + block_meta_data->block_size != limit) {
+            block_meta_data->block_size = limit - (char *)(block_meta_data + 1);
+            block_meta_data->is_zeroed = MM_FALSE;
+        }
+        block_meta_data->tail_gap = 0;
+        if (next_block) {
+            next_block->prev_offset = block_meta_data->offset;
+        }
+        if (mm_is_page_for_appln_empty(page_for_appln)) {
+            mm_delete_and_free_page_for_application(page_for_appln);
+            return;
+        }
+        mm_add_free_block_meta_data_to_free_block_list(structure_family, block_meta_data);
+        block_meta_data = next_block;
     }
-    return nullptr;
 }
 
 
-/* Public function called by the application for dynamic memory allocation */
-void *xcalloc(std::string struct_name, int units) {
+/* Free 'count' data blocks at once, the pointers are sorted so the blocks
+ * of a page are freed together and each family is locked once per run of
+ * its pages, null pointers are skipped, 'app_data_array' is reordered */
+void xfree_batch(void **app_data_array, int count) {
 
-    /* Look for structure family by name */
-    StructureFamily *structure_family = mm_lookup_structure_family_by_name(struct_name);
+    StructureFamily *locked_family{nullptr};
+    std::unique_lock<std::mutex> family_lock;
+    uint64_t freed{0}, bytes_requested{0}, bytes_consumed{0};
+    uint64_t block_requested{0}, block_consumed{0};
+    int first{0}, last{0};
 
-    if (structure_family == nullptr) {
-        std::cerr << "Error: Structure " << struct_name 
-                  << " is not registered in the Memory Manager" << std::endl;
-        return nullptr;
-    }
+    /* Counters of a family are moved once, when its run of pages ends */
+    auto account_family = [&]() {
+        if (locked_family) {
+            locked_family->counters.free_count.fetch_add(freed, std::memory_order_relaxed);
+            mm_stats_account_bytes(locked_family->counters, 
+                -(int64_t)bytes_requested, -(int64_t)bytes_consumed);
+        }
+        freed = bytes_requested = bytes_consumed = 0;
+    };
 
-    if (units * structure_family->struct_size > MAX_PAGE_ALLOCATABLE_MEMORY) {
-        std::cerr << "Error: Memory requested exceeds page size" << std::endl;
-        return nullptr;
+    std::sort(app_data_array, app_data_array + count);
+    while (first < count && app_data_array[first] == nullptr) {
+        first++;
     }
 
-    /* Find the page which can satisfy the request */
-    BlockMetaData *free_block_meta_data = nullptr;
-    free_block_meta_data = mm_allocate_free_data_block(
-        structure_family, units * structure_family->struct_size);
-    
-    if (free_block_meta_data) {
-        /* Fill in with zero */
-        memset((char *)(free_block_meta_data + 1), 0, 
-            free_block_meta_data->block_size);
-        /* Jump to the data block, instead of meta block */
-        return (char *)(free_block_meta_data + 1); 
-    }
-    return nullptr;
-}
+    while (first < count) {
+        PageForApplication *page_for_appln = mm_get_page_from_data_block(app_data_array[first]);
+        StructureFamily *structure_family = page_for_appln->structure_family;
 
+        if (page_for_appln->page_kind == MM_PAGE_REGION) {
+            first++;
+            continue;
+        }
 
-/* Get the size of the hard mode free data block */
-static int
-mm_get_hard_internal_memory_frag_size(
-        BlockMetaData *first,
-        BlockMetaData *second) {
-    
-    BlockMetaData *next_block = next_meta_block_by_size(first);
-    return (int)((unsigned long)second - (unsigned long)next_block);
+        if (structure_family != locked_family) {
+            account_family();
+            if (family_lock.owns_lock()) {
+                family_lock.unlock();
+            }
+            family_lock = mm_lock_if_thread_safe(structure_family->family_lock);
+            locked_family = structure_family;
+        }
+
+        last = first;
+        while (last < count && mm_get_page_from_data_block(app_data_array[last]) == page_for_appln) {
+            mm_take_back_data_block(app_data_array[last]);
+            mm_data_block_footprint(page_for_appln, app_data_array[last], 
+                &block_requested, &block_consumed);
+            bytes_requested += block_requested;
+            bytes_consumed += block_consumed;
+            last++;
+        }
+        freed += last - first;
+
+        if (page_for_appln->page_kind == MM_PAGE_BLOCKS) {
+            mm_free_blocks_of_page(structure_family, page_for_appln, 
+                app_data_array + first, last - first);
+        } else {
+            for (int i = first; i < last; i++) {
+                mm_free_data_block(app_data_array[i]);
+            }
+        }
+        first = last;
+    }
+    account_family();
 }
 
 
-/* Union two free data blocks */
-static void
-mm_union_free_blocks(BlockMetaData *first, BlockMetaData *second){
+/* Give all the blocks cached by the calling thread back to their
+ * structure families, or to the CPU cache if enabled, and free the 
+ * blocks waiting on the remote free stacks (thread safe mode only, 
+ * done on thread exit too) */
+void mm_thread_cache_flush() {
 
-    assert(first->is_free == MM_TRUE &&
-        second->is_free == MM_TRUE);
+    PageForStructFamilies *vm_page_for_families_curr{nullptr};
+    vm_bool cached = (thread_cache.torn_down || thread_cache.bins.empty()) ? MM_FALSE : MM_TRUE;
 
-    first->block_size += sizeof(BlockMetaData) +
-            second->block_size;
+    if (!cached && !mm_init_options.remote_free) {
+        return;
+    }
+    std::unique_lock<std::mutex> registration_lock = 
+        mm_lock_if_thread_safe(structure_family_registration_lock);
 
-    remove_glthread(&first->priority_thread_glue);
-    remove_glthread(&second->priority_thread_glue);
-    mm_bind_blocks_for_deallocation(first, second);
+    vm_page_for_families_curr = first_vm_page_for_families;
+    while (vm_page_for_families_curr) {
+        for (auto &structure_family: *vm_page_for_families_curr) {
+            if (cached && structure_family.family_id < thread_cache.bins.size()) {
+                ThreadCacheBin &bin = thread_cache.bins[structure_family.family_id];
+                mm_thread_cache_flush_bin(&structure_family, bin, bin.count);
+            }
+            if (mm_init_options.remote_free) {
+                std::unique_lock<std::mutex> family_lock = 
+                    mm_lock_if_thread_safe(structure_family.family_lock);
+                mm_remote_free_drain(&structure_family);
+            }
+        }
+        vm_page_for_families_curr = vm_page_for_families_curr->next;
+    }
 }
 
 
-/* Called by xfree to release the memory used by some application data */
-static BlockMetaData*
-mm_free_blocks(BlockMetaData *to_be_free_block) {
+/* Give all the blocks cached by every CPU back to their structure families */
+void mm_cpu_cache_flush() {
 
-    BlockMetaData *return_block{nullptr};
+    PageForStructFamilies *vm_page_for_families_curr{nullptr};
 
-    /* Get the page for application where the 'to_be_free_block' lies */
-    assert(to_be_free_block->is_free == MM_FALSE);
-    PageForApplication *hosting_page = 
-        reinterpret_cast<PageForApplication*>(mm_get_page_from_meta_block(to_be_free_block));
-    
-    /* Get the page family back */
-    StructureFamily *structure_family = hosting_page->structure_family;
+    std::unique_lock<std::mutex> registration_lock = 
+        mm_lock_if_thread_safe(structure_family_registration_lock);
+
+    for (uint32_t cpu = 0; cpu < cpu_cache_count; cpu++) {
+        std::unique_lock<std::mutex> cpu_lock(cpu_caches[cpu].cpu_lock);
+        vm_page_for_families_curr = first_vm_page_for_families;
+        while (vm_page_for_families_curr) {
+            for (auto &structure_family: *vm_page_for_families_curr) {
+                if (structure_family.family_id < cpu_caches[cpu].bins.size() &&
+                        cpu_caches[cpu].bins[structure_family.family_id]) {
+                    CpuCacheBin &cpu_bin = *cpu_caches[cpu].bins[structure_family.family_id];
+                    mm_cpu_cache_flush_bin(&structure_family, cpu_bin, cpu_bin.count);
+                }
+            }
+            vm_page_for_families_curr = vm_page_for_families_curr->next;
+        }
+    }
+}
 
-    /* Free the target meta block, and check different situations */
-    return_block = to_be_free_block;
-    to_be_free_block->is_free = MM_TRUE;
 
-    BlockMetaData *next_block = next_meta_block(to_be_free_block);
+/* Flush the cache of an exiting thread back to the families */
+ThreadCache::~ThreadCache() {
+    mm_thread_cache_flush();
+    torn_down = MM_TRUE;
+}
 
-    /* Scenario 1: the data block to be freed is not 
-     * the last uppermost block in a application page */
-    if (next_block) {
-        to_be_free_block->block_size +=
-            mm_get_hard_internal_memory_frag_size(to_be_free_block, next_block);
-    } 
-    /* Scenario 2: Page boundary condition */
-    else {
-        /* The uppermost top of the page */
-        char *end_address_of_vm_page = 
-            reinterpret_cast<char *>((char *)hosting_page + SYSTEM_PAGE_SIZE);
-        /* The address of the uppermost hard free data block */
-        char *end_address_of_free_data_block = 
-            reinterpret_cast<char *>(to_be_free_block + 1) + to_be_free_block->block_size;
-        /* The size of the uppermost hard free data block */
-        uint32_t internal_mem_fragmentation = 
-            (int)((unsigned long)end_address_of_vm_page - (unsigned long)end_address_of_free_data_block);
-        to_be_free_block->block_size += internal_mem_fragmentation;
-    }
 
-    /* Merging process, merge the free blocks above and beneath */
-    if (next_block && next_block->is_free == MM_TRUE) {
-        /* Union two free blocks */
-        mm_union_free_blocks(to_be_free_block, next_block);
-        return_block = to_be_free_block;
-    }
-    BlockMetaData *prev_block = prev_meta_block(to_be_free_block);
-    if (prev_block && prev_block->is_free == MM_TRUE) {
-        mm_union_free_blocks(prev_block, to_be_free_block);
-        return_block = prev_block;
-    }
+/* Read the statistics of all the registered structure families,
+ * the counters are kept up to date so no page is walked */
+MmStats mm_get_stats() {
 
-    /* If the page for application is empty, release the page back to kernal */
-    if (mm_is_page_for_appln_empty(hosting_page)) {
-        mm_delete_and_free_page_for_application(hosting_page);
-        return nullptr;
-    }
+    MmStats stats;
+    PageForStructFamilies *vm_page_for_families_curr{nullptr};
 
-    /* Add the big empty data block to the priority queue */
-    mm_add_free_block_meta_data_to_free_block_list(
-        hosting_page->structure_family, return_block);
+    std::unique_lock<std::mutex> registration_lock = 
+        mm_lock_if_thread_safe(structure_family_registration_lock);
 
-    return return_block;
+    vm_page_for_families_curr = first_vm_page_for_families;
+    while (vm_page_for_families_curr) {
+        for (auto &structure_family: *vm_page_for_families_curr) {
+            std::unique_lock<std::mutex> family_lock = 
+                mm_lock_if_thread_safe(structure_family.family_lock);
+            FamilyCounters &counters = structure_family.counters;
+            MmFamilyStats family_stats;
+
+            family_stats.struct_name = structure_family.struct_name;
+            family_stats.struct_size = structure_family.struct_size;
+            family_stats.pages = counters.page_count;
+            family_stats.cached_pages = structure_family.cached_page_count + 
+                (uint64_t)structure_family.cached_run_count * structure_family.run_page_units;
+            family_stats.free_blocks = counters.free_block_count;
+            family_stats.alloc_count = counters.alloc_count.load(std::memory_order_relaxed);
+            family_stats.free_count = counters.free_count.load(std::memory_order_relaxed);
+            family_stats.allocated_blocks = family_stats.alloc_count - family_stats.free_count;
+            family_stats.bytes_requested = counters.bytes_requested.load(std::memory_order_relaxed);
+            family_stats.bytes_consumed = counters.bytes_consumed.load(std::memory_order_relaxed);
+            family_stats.peak_bytes_consumed = 
+                counters.peak_bytes_consumed.load(std::memory_order_relaxed);
+
+            stats.pages += family_stats.pages;
+            stats.bytes_requested += family_stats.bytes_requested;
+            stats.bytes_consumed += family_stats.bytes_consumed;
+            stats.families.push_back(std::move(family_stats));
+        }
+        vm_page_for_families_curr = vm_page_for_families_curr->next;
+    }
+    /* Families are pushed to the head of the pages for families */
+    std::sort(stats.families.begin(), stats.families.end(), 
+        [](const MmFamilyStats &a, const MmFamilyStats &b) { 
+            return a.struct_name < b.struct_name; });
+
+    stats.regions = region_count.load(std::memory_order_relaxed);
+    stats.region_pages = region_page_count.load(std::memory_order_relaxed);
+
+    /* Same order as 'mm_page_cache_release' */
+    std::unique_lock<std::mutex> page_cache_lock = 
+        mm_lock_if_thread_safe(page_cache_global_lock);
+    std::unique_lock<std::mutex> arena_guard = mm_lock_if_thread_safe(arena_lock);
+    stats.arenas = arena_count;
+    for (int numa_node = MM_NUMA_NODE_ANY; numa_node < (int)numa_node_count; numa_node++) {
+        MmNumaNodeStats node_stats;
+        uint32_t pool = mm_numa_pool(numa_node);
+
+        node_stats.node = numa_node;
+        node_stats.pages = numa_pool_page_count[pool].load(std::memory_order_relaxed);
+        node_stats.cached_pages = cached_pages_global[pool].size();
+        node_stats.arenas = arena_count_per_pool[pool];
+        stats.global_cached_pages += node_stats.cached_pages;
+        if (node_stats.pages || node_stats.cached_pages || node_stats.arenas) {
+            stats.numa_nodes.push_back(node_stats);
+        }
+    }
+    return stats;
 }
 
 
-/* The API for application call to free application data block */
-void xfree(void *app_data) {
+/* Escape a structure name for a JSON string */
+static std::string mm_json_escape(const std::string &str) {
+    std::ostringstream escaped;
+    for (char c: str) {
+        if (c == '"' || c == '\\') {
+            escaped << '\\' << c;
+        } else if ((unsigned char)c < 0x20) {
+            escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c;
+        } else {
+            escaped << c;
+        }
+    }
+    return escaped.str();
+}
 
-    /*Get the guardian meta block of current data block by subtracting the size of Meta Block*/
-    BlockMetaData *block_meta_data = 
-        reinterpret_cast<BlockMetaData*>((char *)app_data - sizeof(BlockMetaData));
-    
-    /*Assert we get the right thing, and free the data block*/
-    if(block_meta_data->is_free == MM_TRUE){
-        std::cerr << "Error: Double free detected" << std::endl;
-        exit(-1);
+
+/* Statistics as a JSON document */
+std::string mm_stats_to_json(const MmStats &stats) {
+
+    std::ostringstream json;
+
+    json << "{\"page_size\":" << SYSTEM_PAGE_SIZE
+         << ",\"arenas\":" << stats.arenas
+         << ",\"global_cached_pages\":" << stats.global_cached_pages
+         << ",\"pages\":" << stats.pages
+         << ",\"bytes_requested\":" << stats.bytes_requested
+         << ",\"bytes_consumed\":" << stats.bytes_consumed
+         << ",\"regions\":" << stats.regions
+         << ",\"region_pages\":" << stats.region_pages
+         << ",\"numa_nodes\":[";
+    for (size_t i = 0; i < stats.numa_nodes.size(); i++) {
+        const MmNumaNodeStats &node_stats = stats.numa_nodes[i];
+        json << (i ? "," : "")
+             << "{\"node\":" << node_stats.node
+             << ",\"pages\":" << node_stats.pages
+             << ",\"cached_pages\":" << node_stats.cached_pages
+             << ",\"arenas\":" << node_stats.arenas << "}";
     }
-    mm_free_blocks(block_meta_data);
+    json << "],\"families\":[";
+    for (size_t i = 0; i < stats.families.size(); i++) {
+        const MmFamilyStats &family_stats = stats.families[i];
+        json << (i ? "," : "")
+             << "{\"name\":\"" << mm_json_escape(family_stats.struct_name) << "\""
+             << ",\"struct_size\":" << family_stats.struct_size
+             << ",\"pages\":" << family_stats.pages
+             << ",\"cached_pages\":" << family_stats.cached_pages
+             << ",\"allocated_blocks\":" << family_stats.allocated_blocks
+             << ",\"free_blocks\":" << family_stats.free_blocks
+             << ",\"bytes_requested\":" << family_stats.bytes_requested
+             << ",\"bytes_consumed\":" << family_stats.bytes_consumed
+             << ",\"peak_bytes_consumed\":" << family_stats.peak_bytes_consumed
+             << ",\"alloc_count\":" << family_stats.alloc_count
+             << ",\"free_count\":" << family_stats.free_count << "}";
+    }
+    json << "]}";
+    return json.str();
 }
 
 
@@ -514,7 +3208,8 @@ void mm_print_memory_usage() {
     uint32_t block_size{0};
     uint32_t offset{0};
     uint32_t total_pages{0};
-    uint32_t total_memory{0};
+    uint32_t cached_pages{0};
+    uint64_t total_memory{0};
     
     std::string prev_block_addr;
     std::string curr_block_addr;
@@ -530,16 +3225,21 @@ void mm_print_memory_usage() {
 
     std::cout << "\nPage Size = " << SYSTEM_PAGE_SIZE << " Bytes" << std::endl;
 
+    std::unique_lock<std::mutex> registration_lock = 
+        mm_lock_if_thread_safe(structure_family_registration_lock);
     vm_page_for_families_curr = first_vm_page_for_families;
 
     /* Iterate over all the page for structure families */
     while(vm_page_for_families_curr) {
         
         /* For each family, do something */
-        for(const auto &structure_family: 
-                vm_page_for_families_curr->structure_family) {
+        for(auto &structure_family: *vm_page_for_families_curr) {
             
+            std::unique_lock<std::mutex> family_lock = 
+                mm_lock_if_thread_safe(structure_family.family_lock);
             page_count = 0;
+            cached_pages += structure_family.cached_page_count + 
+                structure_family.cached_run_count * structure_family.run_page_units;
             std::cout << "\033[32mStructure Family: " << structure_family.struct_name
                       << ", struct size = " << structure_family.struct_size << "\033[0m\n";
 
@@ -575,22 +3275,15 @@ void mm_print_memory_usage() {
                 /* Iterate over all data block inside the page for appln */
                 while(block_meta_data_curr){
 
-                    if(block_meta_data_curr->is_free == MM_FALSE){
-                        assert(IS_GLTHREAD_LIST_EMPTY(
-                            &block_meta_data_curr->priority_thread_glue));
-                    }
-
-                    if(block_meta_data_curr->is_free == MM_TRUE){
-                        assert(!IS_GLTHREAD_LIST_EMPTY(
-                            &block_meta_data_curr->priority_thread_glue));
-                    }
+                    assert(block_meta_data_curr->is_indexed == 
+                        block_meta_data_curr->is_free);
                     
                     prev_block_addr = get_format_pointer_address(
-                        block_meta_data_curr->prev_block);
+                        prev_meta_block(block_meta_data_curr));
                     curr_block_addr = get_format_pointer_address(
                         block_meta_data_curr);
                     next_block_addr = get_format_pointer_address(
-                        block_meta_data_curr->next_block);
+                        next_meta_block(block_meta_data_curr));
 
                     block_count++;
                     offset = block_meta_data_curr->offset;
@@ -609,22 +3302,80 @@ void mm_print_memory_usage() {
                               << std::endl;
 
                     block_meta_data_curr = 
-                        block_meta_data_curr->next_block;
+                        next_meta_block(block_meta_data_curr);
                 }
                 std::cout << std::endl;
                 page_for_appln_curr = 
                     page_for_appln_curr->next;
             }
+
+            /* Slab pages only have a slot count to show */
+            page_for_appln_curr = structure_family.first_slab_page;
+            while(page_for_appln_curr) {
+
+                page_count++;
+                total_pages++;
+
+                std::cout << std::setfill(' ') << std::setw(18) << ' '
+                          << "slab page local = " << get_format_pointer_address(page_for_appln_curr)
+                          << ", count = " << page_count
+                          << ", slot size = " << structure_family.slab_slot_size
+                          << ", slots in use = " << page_for_appln_curr->slab_page_data.in_use_count
+                          << "/" << structure_family.slab_slots_per_page << std::endl;
+                page_for_appln_curr = 
+                    page_for_appln_curr->next;
+            }
+
+            /* A large page run holds a single object */
+            page_for_appln_curr = structure_family.first_large_page;
+            while(page_for_appln_curr) {
+
+                page_count++;
+                total_pages += page_for_appln_curr->large_page_data.page_units;
+
+                std::cout << std::setfill(' ') << std::setw(18) << ' '
+                          << "large page run local = " << get_format_pointer_address(page_for_appln_curr)
+                          << ", count = " << page_count
+                          << ", pages = " << page_for_appln_curr->large_page_data.page_units
+                          << ", object size = " << page_for_appln_curr->large_page_data.object_size 
+                          << std::endl;
+                page_for_appln_curr = 
+                    page_for_appln_curr->next;
+            }
         }
         vm_page_for_families_curr = 
             vm_page_for_families_curr->next;
     }
 
+    {
+        std::unique_lock<std::mutex> page_cache_lock = 
+            mm_lock_if_thread_safe(page_cache_global_lock);
+        for (auto &cached_pages_of_node: cached_pages_global) {
+            cached_pages += cached_pages_of_node.size();
+        }
+    }
+
     total_memory = total_pages * SYSTEM_PAGE_SIZE;
     std::cout << "\033[35m# Of VM Pages in Use : " << total_pages 
               << " (" << total_memory << " Bytes)\033[0m\n";
+    {
+        std::unique_lock<std::mutex> arena_guard = mm_lock_if_thread_safe(arena_lock);
+        std::cout << "# Of Arenas Reserved : " << arena_count 
+                  << " (" << (uint64_t)arena_count * mm_init_options.arena_size << " Bytes)" << std::endl;
+    }
+    std::cout << "# Of Regions : " << region_count.load(std::memory_order_relaxed)
+              << " (" << region_page_count.load(std::memory_order_relaxed) << " VM Pages)" << std::endl;
+    for (uint32_t numa_node = 0; numa_node < numa_node_count; numa_node++) {
+        uint64_t node_pages = numa_pool_page_count[mm_numa_pool(numa_node)].load(
+            std::memory_order_relaxed);
+        if (node_pages) {
+            std::cout << "# Of VM Pages on NUMA Node " << numa_node << " : " << node_pages << std::endl;
+        }
+    }
+    std::cout << "# Of Empty VM Pages Retained : " << cached_pages 
+              << " (" << (uint64_t)cached_pages * SYSTEM_PAGE_SIZE << " Bytes)" << std::endl;
     std::cout << "Total Memory being used by Memory Manager = "
-              << total_memory << " Bytes" << std::endl;
+              << total_memory + (uint64_t)cached_pages * SYSTEM_PAGE_SIZE << " Bytes" << std::endl;
 
 }
 
@@ -638,7 +3389,7 @@ void mm_print_block_usage() {
     PageForStructFamilies *vm_page_for_families_curr{nullptr};
     BlockMetaData *block_meta_data_curr{nullptr};
 
-    uint32_t application_memory_usage{0};
+    uint64_t application_memory_usage{0};
     uint32_t total_block_count{0}, free_block_count{0}, occupied_block_count{0};
     
     const uint32_t name_length              {20};
@@ -647,15 +3398,18 @@ void mm_print_block_usage() {
     const uint32_t occup_block_length       {12};
     const uint32_t appln_usage_length       {12};
 
+    std::unique_lock<std::mutex> registration_lock = 
+        mm_lock_if_thread_safe(structure_family_registration_lock);
     vm_page_for_families_curr = first_vm_page_for_families;
 
     /* Iterate over all the page for structure families */
     while(vm_page_for_families_curr) {
         
         /* For each family, do something */
-        for(const auto &structure_family: 
-                vm_page_for_families_curr->structure_family) {
+        for(auto &structure_family: *vm_page_for_families_curr) {
             
+            std::unique_lock<std::mutex> family_lock = 
+                mm_lock_if_thread_safe(structure_family.family_lock);
             total_block_count = 0;
             free_block_count = 0;
             occupied_block_count = 0;
@@ -674,15 +3428,8 @@ void mm_print_block_usage() {
                     
                     total_block_count++;
 
-                    if(block_meta_data_curr->is_free == MM_FALSE){
-                        assert(IS_GLTHREAD_LIST_EMPTY(
-                            &block_meta_data_curr->priority_thread_glue));
-                    }
-
-                    if(block_meta_data_curr->is_free == MM_TRUE){
-                        assert(!IS_GLTHREAD_LIST_EMPTY(
-                            &block_meta_data_curr->priority_thread_glue));
-                    }
+                    assert(block_meta_data_curr->is_indexed == 
+                        block_meta_data_curr->is_free);
 
                     if(block_meta_data_curr->is_free == MM_TRUE){
                         free_block_count++;
@@ -694,11 +3441,34 @@ void mm_print_block_usage() {
                         occupied_block_count++; /* One large block is also A BLOCK, not several units of blocks */
                     }
                     block_meta_data_curr = 
-                        block_meta_data_curr->next_block;
+                        next_meta_block(block_meta_data_curr);
                 }
                 page_for_appln_curr = 
                     page_for_appln_curr->next;
             }
+
+            /* Every slot of a slab page is a block without a meta block */
+            page_for_appln_curr = structure_family.first_slab_page;
+            while(page_for_appln_curr) {
+                total_block_count += structure_family.slab_slots_per_page;
+                free_block_count += structure_family.slab_slots_per_page - 
+                    page_for_appln_curr->slab_page_data.in_use_count;
+                occupied_block_count += page_for_appln_curr->slab_page_data.in_use_count;
+                application_memory_usage += page_for_appln_curr->slab_page_data.in_use_count * 
+                    structure_family.slab_slot_size;
+                page_for_appln_curr = 
+                    page_for_appln_curr->next;
+            }
+
+            /* A large object is also A BLOCK */
+            page_for_appln_curr = structure_family.first_large_page;
+            while(page_for_appln_curr) {
+                total_block_count++;
+                occupied_block_count++;
+                application_memory_usage += page_for_appln_curr->large_page_data.object_size;
+                page_for_appln_curr = 
+                    page_for_appln_curr->next;
+            }
             /* Statistic information screen out */
             std::cout << std::setw(name_length) << std::left << structure_family.struct_name
                       << std::left << "TBC: " << std::setw(total_count_length) << total_block_count
@@ -710,4 +3480,203 @@ void mm_print_block_usage() {
         vm_page_for_families_curr = 
             vm_page_for_families_curr->next;
     }
-}
\ No newline at end of file
+}
+
+/* Record the occupancy of a page in the histogram and 
+ * list the page if it is sparse */
+static void
+mm_fragmentation_account_page(MmFamilyFragmentation &family_frag, double sparse_page_occupancy,
+        PageForApplication *page_for_appln, uint32_t live_blocks, 
+        uint32_t used_bytes, uint32_t allocatable_bytes) {
+
+    double occupancy = (double)used_bytes / allocatable_bytes;
+    uint32_t bucket = std::min<uint32_t>(occupancy * MM_OCCUPANCY_BUCKETS, MM_OCCUPANCY_BUCKETS - 1);
+
+    family_frag.pages++;
+    family_frag.occupancy_histogram[bucket]++;
+    if (occupancy < sparse_page_occupancy) {
+        family_frag.sparse_pages.push_back({page_for_appln, 
+            page_for_appln->page_kind == MM_PAGE_SLAB, live_blocks, used_bytes, occupancy});
+    }
+}
+
+
+/* Walk the block pages, slab pages and large page runs of a family
+ * with the family lock held */
+static void
+mm_analyze_family_fragmentation(StructureFamily *structure_family,
+        MmFamilyFragmentation &family_frag, double sparse_page_occupancy) {
+
+    PageForApplication *page_for_appln_curr{nullptr};
+    BlockMetaData *block_meta_data_curr{nullptr};
+    uint32_t live_blocks{0}, used_bytes{0};
+
+    family_frag.struct_name = structure_family->struct_name;
+    family_frag.struct_size = structure_family->struct_size;
+
+    page_for_appln_curr = structure_family->first_page;
+    while (page_for_appln_curr) {
+        live_blocks = 0;
+        used_bytes = 0;
+        block_meta_data_curr = &page_for_appln_curr->block_meta_data;
+        while (block_meta_data_curr) {
+            family_frag.meta_data_bytes += sizeof(BlockMetaData);
+            if (block_meta_data_curr->is_free == MM_TRUE) {
+                family_frag.free_bytes += block_meta_data_curr->block_size;
+                family_frag.largest_free_block = std::max<uint64_t>(
+                    family_frag.largest_free_block, block_meta_data_curr->block_size);
+                /* Left over by 'mm_split_free_data_block_for_application' */
+                if (block_meta_data_curr->block_size < structure_family->struct_size) {
+                    family_frag.soft_internal_frag_bytes += block_meta_data_curr->block_size;
+                    family_frag.soft_internal_frag_blocks++;
+                }
+            } else {
+                live_blocks++;
+                used_bytes += block_meta_data_curr->block_size;
+                /* Gap up to the next meta block or the page top, only freeing
+                 * the block gives it back (see 'mm_free_blocks') */
+                family_frag.hard_internal_frag_bytes += block_meta_data_curr->tail_gap;
+            }
+            block_meta_data_curr = next_meta_block(block_meta_data_curr);
+        }
+        mm_fragmentation_account_page(family_frag, sparse_page_occupancy, page_for_appln_curr,
+            live_blocks, used_bytes, mm_max_page_allocatable_memory(1));
+        page_for_appln_curr = page_for_appln_curr->next;
+    }
+
+    page_for_appln_curr = structure_family->first_slab_page;
+    while (page_for_appln_curr) {
+        live_blocks = page_for_appln_curr->slab_page_data.in_use_count;
+        family_frag.free_slab_slots += structure_family->slab_slots_per_page - live_blocks;
+        mm_fragmentation_account_page(family_frag, sparse_page_occupancy, page_for_appln_curr,
+            live_blocks, live_blocks * structure_family->slab_slot_size,
+            structure_family->slab_slots_per_page * structure_family->slab_slot_size);
+        page_for_appln_curr = page_for_appln_curr->next;
+    }
+
+    /* A large page run is never sparse, its tail is plain waste */
+    page_for_appln_curr = structure_family->first_large_page;
+    while (page_for_appln_curr) {
+        family_frag.pages += page_for_appln_curr->large_page_data.page_units;
+        family_frag.large_tail_bytes += 
+            (uint64_t)page_for_appln_curr->large_page_data.page_units * SYSTEM_PAGE_SIZE -
+            page_for_appln_curr->large_page_data.object_offset - 
+            page_for_appln_curr->large_page_data.object_size;
+        page_for_appln_curr = page_for_appln_curr->next;
+    }
+
+    if (family_frag.free_bytes) {
+        family_frag.external_fragmentation = 
+            1.0 - (double)family_frag.largest_free_block / family_frag.free_bytes;
+    }
+    std::sort(family_frag.sparse_pages.begin(), family_frag.sparse_pages.end(),
+        [](const MmSparsePage &a, const MmSparsePage &b) { return a.occupancy < b.occupancy; });
+}
+
+
+/* Walk every page of every family and measure fragmentation */
+MmFragmentationReport mm_analyze_fragmentation(double sparse_page_occupancy) {
+
+    MmFragmentationReport report;
+    PageForStructFamilies *vm_page_for_families_curr{nullptr};
+
+    report.sparse_page_occupancy = sparse_page_occupancy;
+
+    std::unique_lock<std::mutex> registration_lock = 
+        mm_lock_if_thread_safe(structure_family_registration_lock);
+    vm_page_for_families_curr = first_vm_page_for_families;
+    while (vm_page_for_families_curr) {
+        for (auto &structure_family: *vm_page_for_families_curr) {
+            std::unique_lock<std::mutex> family_lock = 
+                mm_lock_if_thread_safe(structure_family.family_lock);
+            report.families.emplace_back();
+            mm_analyze_family_fragmentation(&structure_family, 
+                report.families.back(), sparse_page_occupancy);
+        }
+        vm_page_for_families_curr = vm_page_for_families_curr->next;
+    }
+    std::sort(report.families.begin(), report.families.end(), 
+        [](const MmFamilyFragmentation &a, const MmFamilyFragmentation &b) { 
+            return a.struct_name < b.struct_name; });
+    return report;
+}
+
+
+/* Print a fragmentation report with hints on families and free patterns */
+void mm_print_fragmentation_report(const MmFragmentationReport &report) {
+
+    const uint32_t sparse_pages_shown{8};
+    uint64_t pinned_bytes{0};
+    uint32_t pinned_blocks{0};
+    /* The percentages are fixed point, the caller's format is put back */
+    std::ios_base::fmtflags saved_flags = std::cout.flags();
+    std::streamsize saved_precision = std::cout.precision();
+
+    for (const auto &family_frag: report.families) {
+        std::cout << "\033[32mStructure Family: " << family_frag.struct_name
+                  << ", struct size = " << family_frag.struct_size
+                  << ", pages = " << family_frag.pages << "\033[0m\n";
+        std::cout << std::setfill(' ') << std::setw(18) << ' '
+                  << "free bytes = " << family_frag.free_bytes
+                  << ", largest free block = " << family_frag.largest_free_block
+                  << ", external fragmentation = " << std::fixed << std::setprecision(1) 
+                  << family_frag.external_fragmentation * 100 << "%" << std::endl;
+        std::cout << std::setfill(' ') << std::setw(18) << ' '
+                  << "hard internal frag = " << family_frag.hard_internal_frag_bytes
+                  << " Bytes, soft internal frag = " << family_frag.soft_internal_frag_bytes
+                  << " Bytes in " << family_frag.soft_internal_frag_blocks << " blocks"
+                  << ", meta blocks = " << family_frag.meta_data_bytes << " Bytes" << std::endl;
+        if (family_frag.free_slab_slots || family_frag.large_tail_bytes) {
+            std::cout << std::setfill(' ') << std::setw(18) << ' '
+                      << "free slab slots = " << family_frag.free_slab_slots
+                      << ", large run tails = " << family_frag.large_tail_bytes << " Bytes" << std::endl;
+        }
+        std::cout << std::setfill(' ') << std::setw(18) << ' ' << "page occupancy  ";
+        for (uint32_t bucket = 0; bucket < MM_OCCUPANCY_BUCKETS; bucket++) {
+            std::cout << bucket * 100 / MM_OCCUPANCY_BUCKETS << "%:" 
+                      << family_frag.occupancy_histogram[bucket] << " ";
+        }
+        std::cout << std::endl;
+
+        pinned_bytes = 0;
+        pinned_blocks = 0;
+        for (size_t i = 0; i < family_frag.sparse_pages.size(); i++) {
+            const MmSparsePage &sparse_page = family_frag.sparse_pages[i];
+            pinned_blocks += sparse_page.live_blocks;
+            pinned_bytes += SYSTEM_PAGE_SIZE;
+            if (i < sparse_pages_shown) {
+                std::cout << std::setfill(' ') << std::setw(22) << ' '
+                          << (sparse_page.slab ? "slab page " : "page ")
+                          << get_format_pointer_address((void *)sparse_page.page)
+                          << "  live blocks = " << sparse_page.live_blocks
+                          << ", used = " << sparse_page.used_bytes << " Bytes ("
+                          << sparse_page.occupancy * 100 << "%)" << std::endl;
+            }
+        }
+
+        /* Compaction hints */
+        if (!family_frag.sparse_pages.empty()) {
+            std::cout << "\033[35m  hint: " << family_frag.sparse_pages.size() 
+                      << " pages below " << report.sparse_page_occupancy * 100 
+                      << "% occupancy pin " << pinned_bytes << " Bytes for " << pinned_blocks
+                      << " live blocks, free or reallocate them together, or give long lived"
+                      << " objects a family of their own\033[0m\n";
+        }
+        if (family_frag.external_fragmentation > 0.5 && 
+                family_frag.free_bytes > SYSTEM_PAGE_SIZE) {
+            std::cout << "\033[35m  hint: free memory is scattered over many small blocks,"
+                      << " the segregated fit free list policy or slab mode reuses them better\033[0m\n";
+        }
+        if (family_frag.soft_internal_frag_blocks > family_frag.pages) {
+            std::cout << "\033[35m  hint: splits leave free blocks smaller than the structure,"
+                      << " uniform unit counts or slab mode avoid them\033[0m\n";
+        }
+        if (family_frag.hard_internal_frag_bytes > family_frag.pages * sizeof(BlockMetaData)) {
+            std::cout << "\033[35m  hint: " << family_frag.hard_internal_frag_bytes 
+                      << " Bytes are stuck between blocks, a page size multiple of the"
+                      << " structure size lets the blocks tile the page\033[0m\n";
+        }
+    }
+    std::cout.flags(saved_flags);
+    std::cout.precision(saved_precision);
+}
@@ -5,7 +5,12 @@
 #include <memory>
 #include <sstream>
 #include <algorithm>
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
 #include "gluethread/glthread.h"
+#include "uapi_mm.h"
 
 
 extern size_t SYSTEM_PAGE_SIZE;
@@ -13,51 +18,376 @@ enum vm_bool: bool {MM_FALSE = false, MM_TRUE = true};
 struct PageForApplication;
 
 
+/* Segregated fit bins: the first level is the power of two of the 
+ * block size, the second level splits each power of two linearly */
+const uint32_t MM_FREE_BIN_SL_LOG2 = 2;
+const uint32_t MM_FREE_BIN_SL_COUNT = 1 << MM_FREE_BIN_SL_LOG2;
+const uint32_t MM_FREE_BIN_FL_COUNT = 16; /* Blocks never outgrow one VM page */
+
+
+/* Segregated free block index of a structure family,
+ * non empty bins are tracked by bitmaps for O(1) lookup */
+struct FreeBlockBins {
+    uint32_t fl_bitmap{0};
+    uint32_t sl_bitmap[MM_FREE_BIN_FL_COUNT]{};
+    glthread_t bin_head[MM_FREE_BIN_FL_COUNT][MM_FREE_BIN_SL_COUNT]{};
+};
+
+
+/* Counters of a structure family maintained on the alloc/free paths, the 
+ * page and free block counts change with the family lock held, the others
+ * also change on the lock free thread cache paths so they are atomics */
+struct FamilyCounters {
+    uint64_t page_count{0};       /* VM pages of block, slab and large pages */
+    uint64_t free_block_count{0}; /* Free meta blocks in the free block index */
+    std::atomic<uint64_t> alloc_count{0};
+    std::atomic<uint64_t> free_count{0};
+    std::atomic<uint64_t> bytes_requested{0};
+    std::atomic<uint64_t> bytes_consumed{0};
+    std::atomic<uint64_t> peak_bytes_consumed{0};
+};
+
+
 /* A data structure family struct,
  * a family must check in at the very beginning */
 struct StructureFamily {
     std::string struct_name;
     uint32_t struct_size{};
+    uint32_t family_id{}; /* Index of the family in the per thread caches */
+    uint32_t alignment{1}; /* Data blocks of the family start on this boundary */
+    std::mutex family_lock; /* Guards pages and free blocks in thread safe mode */
+    mm_free_list_policy_t free_list_policy{MM_FREE_LIST_WORST_FIT};
     PageForApplication *first_page{nullptr};
+    vm_bool slab_mode{MM_FALSE}; /* Single units are served from slab pages */
+    uint32_t slab_slot_size{};
+    uint32_t slab_slots_per_page{};
+    uint32_t slab_slots_offset{}; /* First slot from the start of a slab page, aligned */
+    PageForApplication *first_slab_page{nullptr};
+    glthread_t slab_partial_list_head; /* Slab pages with at least one free slot */
+    PageForApplication *first_large_page{nullptr}; /* Objects spanning several VM pages */
+    PageForApplication *first_cached_page{nullptr}; /* Empty pages retained for reuse */
+    uint32_t cached_page_count{0};
+    /* Freed page runs of 'run_page_units' VM pages retained for reuse, 
+     * only by the page run size classes, 0 for other families */
+    uint32_t run_page_units{0};
+    PageForApplication *first_cached_run{nullptr};
+    uint32_t cached_run_count{0};
     glthread_t free_block_priority_list_head;
+    FreeBlockBins free_block_bins;
+    FamilyCounters counters;
+    int numa_node{MM_NUMA_NODE_ANY}; /* Node the new pages are placed on */
+    /* Data blocks freed without the family lock, linked through their first
+     * word, freed by the next allocation holding the lock */
+    std::atomic<void *> remote_free_head{nullptr};
     StructureFamily(std::string name_val = "None", uint32_t size_val = 0);
 };
 /* Constructor of StructureFamily */
-StructureFamily::StructureFamily(std::string name_val, uint32_t size_val)
+inline StructureFamily::StructureFamily(std::string name_val, uint32_t size_val)
 : struct_name{name_val}, struct_size{size_val} {  
 }
 
 
-/* A 'hotel' page for structure families to check in */
+/* A 'hotel' page for structure families to check in
+ * Families live inside the page itself and are never moved,
+ * so a StructureFamily pointer is a stable handle */
 struct PageForStructFamilies {
     PageForStructFamilies *next{nullptr};
-    std::vector<StructureFamily> structure_family;
+    uint32_t family_count{0};
+    StructureFamily structure_family[0];
+
+    StructureFamily *begin() { return structure_family; }
+    StructureFamily *end() { return structure_family + family_count; }
 };
 
 
 /* Meta Block - The guardian of Data Block
- * Data Block is 'block_size' above the Meta Block */
+ * Data Block is right above the Meta Block, the next meta block is 
+ * 'block_size' + 'tail_gap' above the data block and the previous one is 
+ * found by its offset, a free block keeps its free block index glue in
+ * its own data block so the meta block stays 16 bytes */
 struct BlockMetaData {
-    vm_bool is_free{MM_TRUE};
     uint32_t block_size{};
-    uint32_t offset{}; /* offset from the start of the page to self location */
-    glthread_t priority_thread_glue;
-    BlockMetaData *prev_block{nullptr};
-    BlockMetaData *next_block{nullptr};
+    uint16_t offset{};      /* offset from the start of the page to self location */
+    uint16_t prev_offset{}; /* offset of the previous meta block, 0 for the lowest one */
+    uint8_t tail_gap{};     /* Hard internal fragment between the data block and the next meta block */
+    uint8_t alignment_log2{}; /* Alignment the data block was asked to start on, 0 for the family one */
+    vm_bool is_free{MM_TRUE};
+    vm_bool is_zeroed{MM_FALSE}; /* Data block is known to be zero filled, the glue aside */
+    vm_bool is_indexed{MM_FALSE}; /* Linked into the free block index of the family */
+    /* Freed by the application while still allocated as far as the family
+     * is concerned, held by a thread or CPU cache, written without the lock */
+    vm_bool is_cached{MM_FALSE};
+};
+static_assert(sizeof(BlockMetaData) == 16, "Meta block must stay compact");
+
+
+/* Largest VM page the 16 bit offsets of the meta blocks can address */
+const size_t MM_MAX_SYSTEM_PAGE_SIZE = 64 * 1024;
+
+
+/* Smallest data block, a free one must be able to hold its index glue */
+const uint32_t MM_MIN_DATA_BLOCK_SIZE = sizeof(glthread_t);
+
+
+/* How the memory of a page for application is handed out */
+enum mm_page_kind_t : uint8_t {
+    MM_PAGE_BLOCKS,     /* Variable sized blocks guarded by meta blocks */
+    MM_PAGE_SLAB,       /* Equal 'slab_slot_size' slots without per object header */
+    MM_PAGE_LARGE,      /* One object over 'page_units' contiguous VM pages */
+    MM_PAGE_REGION      /* Bump allocated objects of any family, released with their region */
+};
+
+
+/* Largest number of slots of a slab page, bounded by the in use bitmap */
+const uint32_t MM_SLAB_BITMAP_WORDS = 8;
+const uint32_t MM_SLAB_MAX_SLOTS_PER_PAGE = MM_SLAB_BITMAP_WORDS * 64;
+
+
+/* Bookkeeping of a slab page, slots are handed out from the 
+ * intrusive free list first, then from the never touched tail */
+struct SlabPageData {
+    uint32_t in_use_count;
+    uint32_t slots_offset;
+    uint32_t bump_index;  /* Slots at and above were never handed out */
+    vm_bool bump_zeroed;  /* Slots never handed out are known to be zero filled */
+    void *free_list;
+    glthread_t partial_glue;
+    /* Slots owned by the application, a slot held by a thread or CPU cache
+     * is clear, changed atomically without the lock, catches double free */
+    uint64_t in_use_bitmap[MM_SLAB_BITMAP_WORDS];
+};
+
+
+/* Bookkeeping of a large object page run, the object 
+ * starts right above it in the first VM page */
+struct LargePageData {
+    uint32_t page_units;
+    uint32_t object_offset; /* From the start of the page, aligned */
+    uint64_t object_size;
+};
+
+
+/* Bookkeeping of a region page, objects are bumped up from 'bump_offset'
+ * and never freed one by one, a page run of 'page_units' holds a large object */
+struct RegionPageData {
+    MmRegion *region;
+    uint32_t page_units;
+    uint32_t bump_offset;
+    vm_bool bump_zeroed;    /* Memory above 'bump_offset' is known to be zero filled */
+};
+
+
+/* A region, it lives in the first page it was given */
+struct MmRegion {
+    PageForApplication *first_page{nullptr}; /* The page being bumped is the head */
+    uint64_t page_count{0};
+    uint64_t bytes_allocated{0};
 };
 
 
 /* Page for application to use
- * A double linked list with a pointer to the structure family it derive from */
+ * A double linked list with a pointer to the structure family it derive from,
+ * a slab page keeps its bookkeeping where the first meta block would be */
 struct PageForApplication {
     PageForApplication *next{nullptr};
     PageForApplication *prev{nullptr};
     StructureFamily *structure_family{nullptr}; 
-    BlockMetaData block_meta_data; /* first meta block right at the bottom */
+    mm_page_kind_t page_kind{MM_PAGE_BLOCKS};
+    int16_t numa_node{MM_NUMA_NODE_ANY}; /* Node the page was placed on */
+    uint32_t page_cookie{0}; /* Derived from the page address while the page is handed out */
+    union {
+        BlockMetaData block_meta_data; /* first meta block right at the bottom */
+        SlabPageData slab_page_data;
+        LargePageData large_page_data;
+        RegionPageData region_page_data;
+    };
     char page_memory[0];
 };
 
 
+/* Header of an arena, a chunk of address space reserved with a single
+ * mmap and carved into pages for application, it takes the first page */
+struct ArenaHeader {
+    glthread_t available_glue; /* Linked while the arena has pages to hand out */
+    int32_t numa_node;         /* Node the whole arena is placed on */
+    uint32_t page_count;       /* Pages for application, the header page excluded */
+    uint32_t bump_index;       /* Pages at and above were never handed out */
+    uint32_t in_use_count;
+    void *free_page_list;      /* Pages handed back, linked through their first word */
+};
+
+
+/* An empty page in the global page cache, 'zeroed' only if its memory
+ * was decommitted (MADV_DONTNEED succeeded) so the next touch faults in zeros */
+struct CachedPage {
+    PageForApplication *page;
+    vm_bool zeroed;
+};
+
+
+/* Largest number of NUMA nodes pages can be placed on, a node mask is one word */
+const uint32_t MM_MAX_NUMA_NODES = 64;
+
+
+/* Arenas, the global page cache and the page counts are kept per NUMA node,
+ * the pool of node MM_NUMA_NODE_ANY comes first */
+inline uint32_t mm_numa_pool(int numa_node) {
+    return (uint32_t)(numa_node + 1);
+}
+
+
+/* Get the arena from its glue in the list of available arenas */
+inline ArenaHeader*
+arena_available_glue_to_arena(glthread_t *glthreadptr) {
+    return (ArenaHeader *)((char *)(glthreadptr) - offsetof(ArenaHeader, available_glue));
+}
+
+
+/* Get the page for application holding a data block of the
+ * application, pages are aligned to the system page size */
+inline PageForApplication*
+mm_get_page_from_data_block(void *app_data) {
+    return reinterpret_cast<PageForApplication*>(
+        (uintptr_t)app_data & ~((uintptr_t)SYSTEM_PAGE_SIZE - 1));
+}
+
+
+/* First slot of a slab page, above the slab bookkeeping */
+inline char*
+mm_slab_page_slots(PageForApplication *page_for_appln) {
+    return (char *)page_for_appln + page_for_appln->slab_page_data.slots_offset;
+}
+
+
+/* Smallest offset of the object of a large page run, 16 bytes aligned */
+const size_t MM_LARGE_OBJECT_OFFSET = 
+    (offsetof(PageForApplication, large_page_data) + sizeof(LargePageData) + 15) & ~(size_t)15;
+
+
+/* Round 'value' up to 'alignment', a power of two */
+inline uint64_t mm_align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+
+/* The object of a large page run */
+inline char*
+mm_large_page_object(PageForApplication *page_for_appln) {
+    return (char *)page_for_appln + page_for_appln->large_page_data.object_offset;
+}
+
+
+/* Objects of a region page start here, 16 bytes aligned */
+const size_t MM_REGION_OBJECT_OFFSET = 
+    (offsetof(PageForApplication, region_page_data) + sizeof(RegionPageData) + 15) & ~(size_t)15;
+
+
+/* Get the slab page from its glue in the partial list of the family */
+inline PageForApplication*
+slab_partial_glue_to_page(glthread_t *glthreadptr) {
+    return (PageForApplication *)((char *)(glthreadptr) - 
+        offsetof(PageForApplication, slab_page_data.partial_glue));
+}
+
+
+/* Size classes of the byte oriented 'xmalloc': 16 byte steps up to 128,
+ * then four classes per power of two up to MM_SIZE_CLASS_MAX */
+const uint32_t MM_SIZE_CLASS_SMALL_COUNT = 8;
+const uint32_t MM_SIZE_CLASS_COUNT = MM_SIZE_CLASS_SMALL_COUNT + 4 * 4;
+const uint32_t MM_SIZE_CLASS_ALIGNMENT = alignof(std::max_align_t);
+
+
+/* Pseudo size class of the requests above a quarter of a VM page, a slab
+ * page would only hold one to three of them, so they share the block pages
+ * of a single family in MM_SIZE_CLASS_ALIGNMENT units, as do the page runs */
+const uint32_t MM_SIZE_CLASS_MEDIUM = MM_SIZE_CLASS_COUNT;
+
+
+/* Requests above MM_SIZE_CLASS_MAX go to a page run size class per run
+ * length up to this many VM pages, each a family with its own lock that
+ * keeps freed runs for reuse, longer runs are mapped under the medium family */
+const uint32_t MM_SIZE_CLASS_RUN_PAGES = 16;
+
+inline uint32_t
+mm_size_class_run(uint32_t page_units) {
+    return MM_SIZE_CLASS_MEDIUM + page_units;
+}
+
+
+/* Index of the smallest size class holding 'size' bytes, up to MM_SIZE_CLASS_MAX */
+inline uint32_t
+mm_size_class_index(size_t size) {
+    if (size <= 128) {
+        return (size ? size - 1 : 0) >> 4;
+    }
+    uint32_t size_log2 = 63 - __builtin_clzll(size - 1);
+    return MM_SIZE_CLASS_SMALL_COUNT + (size_log2 - 7) * 4 + 
+        (uint32_t)((size - 1) >> (size_log2 - 2)) - 4;
+}
+
+
+/* Bytes of a size class */
+inline uint32_t
+mm_size_class_size(uint32_t size_class) {
+    if (size_class < MM_SIZE_CLASS_SMALL_COUNT) {
+        return (size_class + 1) << 4;
+    }
+    uint32_t size_log2 = 7 + (size_class - MM_SIZE_CLASS_SMALL_COUNT) / 4;
+    return (1u << size_log2) + 
+        ((size_class - MM_SIZE_CLASS_SMALL_COUNT) % 4 + 1) * (1u << (size_log2 - 2));
+}
+
+
+/* Largest number of single unit blocks a thread may cache per family */
+const uint32_t MM_THREAD_CACHE_MAX_CAPACITY = 128;
+
+
+/* Data blocks of one structure family cached by a thread,
+ * they stay allocated as far as the family is concerned */
+struct ThreadCacheBin {
+    uint32_t count{0};
+    void *data_blocks[MM_THREAD_CACHE_MAX_CAPACITY];
+    vm_bool zeroed[MM_THREAD_CACHE_MAX_CAPACITY];
+};
+
+
+/* Largest number of single unit blocks a CPU may cache per family */
+const uint32_t MM_CPU_CACHE_MAX_CAPACITY = 512;
+
+
+/* Data blocks of one structure family cached by a CPU, the coldest blocks 
+ * are at the bottom, the arrays hold 'cpu_cache_capacity' blocks */
+struct CpuCacheBin {
+    uint32_t count{0};
+    std::unique_ptr<void*[]> data_blocks;
+    std::unique_ptr<vm_bool[]> zeroed;
+    explicit CpuCacheBin(uint32_t capacity);
+};
+/* Constructor of CpuCacheBin */
+inline CpuCacheBin::CpuCacheBin(uint32_t capacity)
+: data_blocks{new void*[capacity]}, zeroed{new vm_bool[capacity]} {
+}
+
+
+/* Cache of one CPU shared by the threads running on it, the lock is only
+ * contended when a thread migrates or is preempted in the middle of a
+ * refill or flush, so the family locks are taken once per batch of a CPU,
+ * a bin is only allocated once its family is cached on the CPU */
+struct alignas(64) CpuCache {
+    std::mutex cpu_lock;
+    std::vector<std::unique_ptr<CpuCacheBin>> bins; /* Indexed by family id */
+};
+
+
+/* Per thread cache in front of all structure families,
+ * bins are indexed by family id and flushed when the thread exits */
+struct ThreadCache {
+    std::vector<ThreadCacheBin> bins;
+    vm_bool torn_down{MM_FALSE}; /* Frees later on in the thread exit skip the cache */
+    ~ThreadCache();
+};
+
+
 /* From a specific meta block get the page ptr by
  * subtracting the block's offset */
 inline void*
@@ -66,13 +396,6 @@ mm_get_page_from_meta_block(BlockMetaData *block_meta_data_ptr) {
 }
 
 
-/* Short cut of getting the next data block */
-inline BlockMetaData* 
-next_meta_block(BlockMetaData *block_meta_data_ptr) {
-    return block_meta_data_ptr->next_block;
-}
-
-
 /* Get the next meta block by transforming the current
  * meta pointer to unit pointer and incrementing the 
  * size of the data block it is guarding */
@@ -83,56 +406,90 @@ next_meta_block_by_size(BlockMetaData *block_meta_data_ptr) {
 }
 
 
+/* Short cut of getting the next data block, 
+ * blocks of a page reach up to its top */
+inline BlockMetaData* 
+next_meta_block(BlockMetaData *block_meta_data_ptr) {
+    uint64_t next_offset = block_meta_data_ptr->offset + sizeof(BlockMetaData) + 
+        block_meta_data_ptr->block_size + block_meta_data_ptr->tail_gap;
+    if (next_offset >= SYSTEM_PAGE_SIZE) {
+        return nullptr;
+    }
+    return (BlockMetaData *)((char *)next_meta_block_by_size(block_meta_data_ptr) + 
+        block_meta_data_ptr->tail_gap);
+}
+
+
 /* Short cut of getting the previous data block */
 inline BlockMetaData* 
 prev_meta_block(BlockMetaData *block_meta_data_ptr) {
-    return block_meta_data_ptr->prev_block;
+    if (block_meta_data_ptr->prev_offset == 0) {
+        return nullptr;
+    }
+    return (BlockMetaData *)((char *)mm_get_page_from_meta_block(block_meta_data_ptr) + 
+        block_meta_data_ptr->prev_offset);
 }
 
 
-/* Bind two free data block for allocation usage */
+/* Bind two free data block for allocation usage, 'free_meta_block'
+ * is already sized to reach up to the next meta block */
 inline void mm_bind_blocks_for_allocation(
         BlockMetaData *allocated_meta_block,
         BlockMetaData *free_meta_block) {
 
-    free_meta_block->prev_block = allocated_meta_block;
-    free_meta_block->next_block = allocated_meta_block->next_block;
-    allocated_meta_block->next_block = free_meta_block;
-    if (free_meta_block->next_block) {
-        free_meta_block->next_block->prev_block = free_meta_block;
+    BlockMetaData *next_block = next_meta_block(free_meta_block);
+
+    free_meta_block->prev_offset = allocated_meta_block->offset;
+    if (next_block) {
+        next_block->prev_offset = free_meta_block->offset;
     }
 }
 
 
-/* Bind two free data block for deallocation usage */
+/* Bind two free data block for deallocation usage,
+ * 'freed_meta_block_down' already spans both */
 inline void mm_bind_blocks_for_deallocation(
         BlockMetaData *freed_meta_block_down,
         BlockMetaData *freed_meta_block_top) {
-    
-    freed_meta_block_down->next_block = freed_meta_block_top->next_block;
-    if (freed_meta_block_top->next_block) {
-        freed_meta_block_top->next_block->prev_block = freed_meta_block_down;
+
+    BlockMetaData *next_block = next_meta_block(freed_meta_block_down);
+
+    (void)freed_meta_block_top;
+    if (next_block) {
+        next_block->prev_offset = freed_meta_block_down->offset;
     }
 }
 
 
+/* Glue of a free data block in the free block index, it lives at the 
+ * bottom of the data block since only free blocks are ever linked */
+inline glthread_t*
+mm_free_block_glue(BlockMetaData *block_meta_data_ptr) {
+    return reinterpret_cast<glthread_t *>(block_meta_data_ptr + 1);
+}
+
+
 /* Return the max bytes available to applications 
- * ('page memory' is on the highest address) */
+ * (data of the first meta block up to the highest address) */
 inline uint32_t mm_max_page_allocatable_memory(int units) {
     return (uint32_t) ((SYSTEM_PAGE_SIZE * units) - 
-        offsetof(PageForApplication, page_memory));
+        offsetof(PageForApplication, block_meta_data) - sizeof(BlockMetaData));
 }
 
-const uint32_t MAX_PAGE_ALLOCATABLE_MEMORY = 
-    mm_max_page_allocatable_memory(1);
+
+/* Return the number of VM pages a large object of 'size' bytes spans */
+inline uint32_t mm_large_object_page_units(uint64_t size, 
+        uint64_t object_offset = MM_LARGE_OBJECT_OFFSET) {
+    return (uint32_t) ((object_offset + size + SYSTEM_PAGE_SIZE - 1) / SYSTEM_PAGE_SIZE);
+}
 
 
-/* Get the pointer of the meta data block of a 
- * glue thread that lies in by subtracting the offset */
+
+/* Get the pointer of the meta data block of a glue thread
+ * that lies in its data block, right above the meta block */
 inline BlockMetaData*
 glthread_to_block_meta_data(glthread_t *glthreadptr) {
-    return (BlockMetaData *)((char *)(glthreadptr) - 
-        (char *)&(((BlockMetaData *)0)->priority_thread_glue));
+    return (BlockMetaData *)(glthreadptr) - 1;
 }
 
 
@@ -151,6 +508,27 @@ mm_get_biggest_free_block_page_family(
 }
 
 
+/* Map a block size to its segregated fit bin */
+inline void
+mm_free_bin_mapping(uint32_t size, uint32_t *fl, uint32_t *sl) {
+
+    uint32_t fl_raw = 31 - __builtin_clz(size | 1);
+
+    if (fl_raw < MM_FREE_BIN_SL_LOG2) {
+        *fl = 0;
+        *sl = size;
+        return;
+    }
+    *sl = (size >> (fl_raw - MM_FREE_BIN_SL_LOG2)) & (MM_FREE_BIN_SL_COUNT - 1);
+    *fl = fl_raw - MM_FREE_BIN_SL_LOG2 + 1;
+    
+    if (*fl >= MM_FREE_BIN_FL_COUNT) {
+        *fl = MM_FREE_BIN_FL_COUNT - 1;
+        *sl = MM_FREE_BIN_SL_COUNT - 1;
+    }
+}
+
+
 /* Template function to get the format address of a pointer that it points to */
 template <typename T>
 inline std::string get_format_pointer_address(T ptr) {
@@ -168,7 +546,8 @@ inline std::string get_format_pointer_address(T ptr) {
 
 /* Function declaration */
 /* Allocate virtual memory page for applications */
-PageForApplication *mm_allocate_page_for_application(StructureFamily *structure_family);
+PageForApplication *mm_allocate_page_for_application(StructureFamily *structure_family,
+    mm_page_kind_t page_kind = MM_PAGE_BLOCKS, uint32_t page_units = 1, vm_bool *zeroed = nullptr);
 
 
 /* Function declaration */
@@ -176,8 +555,12 @@ PageForApplication *mm_allocate_page_for_application(StructureFamily *structure_
 void mm_delete_and_free_page_for_application(PageForApplication *page_for_appln);
 
 
-const uint32_t MAX_FAMILIES_PER_VM_PAGE = 
-    (SYSTEM_PAGE_SIZE - sizeof(PageForStructFamilies*)) / sizeof(StructureFamily);
+/* Return the max number of structure families a page for families 
+ * can accommodate (only meaningful after 'mm_init') */
+inline uint32_t mm_max_families_per_vm_page() {
+    return (uint32_t) ((SYSTEM_PAGE_SIZE - sizeof(PageForStructFamilies)) / 
+        sizeof(StructureFamily));
+}
 
 
 #endif
\ No newline at end of file
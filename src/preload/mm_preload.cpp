@@ -0,0 +1,388 @@
+#include <new>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <dlfcn.h>
+#include "uapi_mm.h"
+
+/* Drop-in replacement of the C and C++ allocation functions routed to the
+ * size class families of the memory manager, loaded with
+ * LD_PRELOAD=libmm_preload.so to run an unmodified program on it.
+ *
+ * Memory the manager itself allocates (its name index, thread cache bins,
+ * error messages) comes from glibc through a per thread recursion guard,
+ * as does anything allocated before the manager is initialized, frees
+ * tell both apart with 'mm_is_managed_data_block'. Alignments above
+ * MM_MAX_ALIGNMENT are left to glibc too */
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+
+/* Life cycle of the interposition, the manager is only used while ready */
+enum mm_preload_state_t {
+    MM_PRELOAD_UNINITIALIZED,
+    MM_PRELOAD_INITIALIZING,
+    MM_PRELOAD_READY,
+    MM_PRELOAD_FINISHED     /* Static destructors of the manager are running */
+};
+
+static std::atomic<int> mm_preload_state{MM_PRELOAD_UNINITIALIZED};
+
+/* Set while the calling thread runs inside the memory manager */
+static __thread int mm_preload_guard __attribute__((tls_model("initial-exec")));
+
+/* glibc 'malloc_usable_size', for the memory glibc handed out */
+static size_t (*mm_preload_libc_usable_size)(void *ptr){nullptr};
+
+
+/* Set once the memory manager globals are constructed, this file is
+ * linked after them so its constructors run later */
+static bool mm_preload_constructed{false};
+
+__attribute__((constructor)) static void
+mm_preload_construct() {
+    mm_preload_constructed = true;
+}
+
+
+/* Registered at exit after the memory manager globals, so destroyed
+ * before them, the manager is not used past that point */
+struct MmPreloadLifetime {
+    ~MmPreloadLifetime() {
+        mm_preload_state.store(MM_PRELOAD_FINISHED, std::memory_order_release);
+    }
+};
+static MmPreloadLifetime mm_preload_lifetime;
+
+
+/* Holds the recursion guard of the calling thread for a scope */
+struct MmPreloadGuard {
+    MmPreloadGuard() { mm_preload_guard++; }
+    ~MmPreloadGuard() { mm_preload_guard--; }
+};
+
+
+/* Check if an allocation may go to the memory manager, the first call
+ * after the globals are constructed initializes it in thread safe mode,
+ * other threads fall back to glibc meanwhile */
+static inline bool
+mm_preload_ready() {
+
+    int state = mm_preload_state.load(std::memory_order_acquire);
+
+    if (state == MM_PRELOAD_READY) {
+        return mm_preload_guard == 0;
+    }
+    if (state != MM_PRELOAD_UNINITIALIZED || mm_preload_guard || !mm_preload_constructed) {
+        return false;
+    }
+    if (!mm_preload_state.compare_exchange_strong(state, MM_PRELOAD_INITIALIZING)) {
+        return false;
+    }
+    {
+        MmPreloadGuard guard;
+        MmInitOptions options;
+        options.thread_safe = true;
+        mm_init(options);
+        mm_preload_libc_usable_size = reinterpret_cast<size_t (*)(void *)>(
+            dlsym(RTLD_NEXT, "malloc_usable_size"));
+    }
+    mm_preload_state.store(MM_PRELOAD_READY, std::memory_order_release);
+    return true;
+}
+
+
+/* Allocate 'size' bytes starting on 'alignment' (a power of two) */
+static void *
+mm_preload_allocate(size_t size, size_t alignment, bool zero_fill) {
+
+    void *ptr{nullptr};
+
+    if (!mm_preload_ready()) {
+        if (alignment > alignof(std::max_align_t)) {
+            ptr = __libc_memalign(alignment, size);
+        } else {
+            ptr = zero_fill ? __libc_calloc(1, size) : __libc_malloc(size);
+        }
+        return ptr;
+    }
+    if (alignment > MM_MAX_ALIGNMENT) {
+        MmPreloadGuard guard;
+        return __libc_memalign(alignment, size);
+    }
+    {
+        MmPreloadGuard guard;
+        if (alignment > alignof(std::max_align_t)) {
+            ptr = xmalloc_aligned(size, (uint32_t)alignment);
+            if (ptr && zero_fill) {
+                memset(ptr, 0, size);
+            }
+        } else {
+            ptr = zero_fill ? xcalloc(size) : xmalloc(size);
+        }
+    }
+    if (ptr == nullptr) {
+        errno = ENOMEM;
+    }
+    return ptr;
+}
+
+
+/* Give memory back to whichever allocator handed it out */
+static void
+mm_preload_free(void *ptr) {
+
+    if (ptr == nullptr) {
+        return;
+    }
+    if (!mm_is_managed_data_block(ptr)) {
+        __libc_free(ptr);
+        return;
+    }
+    /* Memory still held at exit is left to the kernel */
+    if (mm_preload_state.load(std::memory_order_acquire) == MM_PRELOAD_FINISHED) {
+        return;
+    }
+    MmPreloadGuard guard;
+    xfree(ptr);
+}
+
+
+/* Usable bytes of memory of either allocator */
+static size_t
+mm_preload_usable_size(void *ptr) {
+
+    if (ptr == nullptr) {
+        return 0;
+    }
+    if (mm_is_managed_data_block(ptr)) {
+        return mm_usable_size(ptr);
+    }
+    return mm_preload_libc_usable_size ? mm_preload_libc_usable_size(ptr) : 0;
+}
+
+
+/* Resize memory of either allocator, a managed data block stays in place
+ * while it is big enough and not more than twice the new size */
+static void *
+mm_preload_reallocate(void *ptr, size_t size) {
+
+    if (ptr == nullptr) {
+        return mm_preload_allocate(size, alignof(std::max_align_t), false);
+    }
+    if (size == 0) {
+        mm_preload_free(ptr);
+        return nullptr;
+    }
+    if (!mm_is_managed_data_block(ptr)) {
+        return __libc_realloc(ptr, size);
+    }
+    size_t usable_size = mm_usable_size(ptr);
+    if (size <= usable_size && size >= usable_size / 2) {
+        return ptr;
+    }
+    void *new_ptr = mm_preload_allocate(size, alignof(std::max_align_t), false);
+    if (new_ptr == nullptr) {
+        return nullptr;
+    }
+    memcpy(new_ptr, ptr, std::min(size, usable_size));
+    mm_preload_free(ptr);
+    return new_ptr;
+}
+
+
+/* Check an alignment of the aligned allocation functions */
+static inline bool
+mm_preload_valid_alignment(size_t alignment) {
+    return alignment && (alignment & (alignment - 1)) == 0;
+}
+
+
+/* C allocation functions */
+extern "C" {
+
+void *malloc(size_t size) {
+    return mm_preload_allocate(size, alignof(std::max_align_t), false);
+}
+
+
+void *calloc(size_t count, size_t size) {
+    size_t bytes{0};
+    if (__builtin_mul_overflow(count, size, &bytes)) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    return mm_preload_allocate(bytes, alignof(std::max_align_t), true);
+}
+
+
+void *realloc(void *ptr, size_t size) {
+    return mm_preload_reallocate(ptr, size);
+}
+
+
+void *reallocarray(void *ptr, size_t count, size_t size) {
+    size_t bytes{0};
+    if (__builtin_mul_overflow(count, size, &bytes)) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    return mm_preload_reallocate(ptr, bytes);
+}
+
+
+void free(void *ptr) {
+    mm_preload_free(ptr);
+}
+
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+    if (!mm_preload_valid_alignment(alignment) || alignment % sizeof(void *)) {
+        return EINVAL;
+    }
+    void *ptr = mm_preload_allocate(size, alignment, false);
+    if (ptr == nullptr) {
+        return ENOMEM;
+    }
+    *memptr = ptr;
+    return 0;
+}
+
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    if (!mm_preload_valid_alignment(alignment)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    return mm_preload_allocate(size, alignment, false);
+}
+
+
+void *memalign(size_t alignment, size_t size) {
+    return aligned_alloc(alignment, size);
+}
+
+
+size_t malloc_usable_size(void *ptr) {
+    return mm_preload_usable_size(ptr);
+}
+
+}
+
+
+/* C++ allocation functions, a failed allocation calls the new handler
+ * until it gives up */
+static void *
+mm_preload_new(size_t size, size_t alignment) {
+    while (true) {
+        void *ptr = mm_preload_allocate(size, alignment, false);
+        if (ptr) {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+
+static void *
+mm_preload_new_nothrow(size_t size, size_t alignment) noexcept {
+    try {
+        return mm_preload_new(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+
+void *operator new(size_t size) {
+    return mm_preload_new(size, alignof(std::max_align_t));
+}
+
+void *operator new[](size_t size) {
+    return mm_preload_new(size, alignof(std::max_align_t));
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return mm_preload_new_nothrow(size, alignof(std::max_align_t));
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return mm_preload_new_nothrow(size, alignof(std::max_align_t));
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    return mm_preload_new(size, (size_t)alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+    return mm_preload_new(size, (size_t)alignment);
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return mm_preload_new_nothrow(size, (size_t)alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return mm_preload_new_nothrow(size, (size_t)alignment);
+}
+
+void operator delete(void *ptr) noexcept {
+    mm_preload_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    mm_preload_free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    mm_preload_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    mm_preload_free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    mm_preload_free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    mm_preload_free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    mm_preload_free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    mm_preload_free(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+    mm_preload_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept {
+    mm_preload_free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    mm_preload_free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    mm_preload_free(ptr);
+}
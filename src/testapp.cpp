@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include "uapi_mm.h"
+#include "uapi_mm_allocator.h"
 
 typedef struct emp_ {
     char name[32];
@@ -19,9 +20,9 @@ typedef struct student_ {
 
 class Dean {
 public:
-    std::string name;
+    mm::string name;
     uint32_t establish_year;
-    std::vector<std::string> awards;
+    mm::vector<mm::string> awards;
 };
 
 int main() {
@@ -41,8 +42,8 @@ int main() {
     student_t *stu1 = (student_t*)XCALLOC(1, student_);
     student_t *stu2 = (student_t*)XCALLOC(2, student_);
 
-    Dean *dean1 = (Dean*)XCALLOC(1, Dean);
-    Dean *dean2 = (Dean*)XCALLOC(2, Dean);
+    Dean *dean1 = mm::make<Dean>();
+    mm::vector<Dean> deans(2);
 
     std::cout << "Scenario 1" << std::endl;
     mm_print_memory_usage();
@@ -54,7 +55,7 @@ int main() {
     XFREE(emp1);
     XFREE(emp3);
     XFREE(stu2);
-    XFREE(dean1);
+    mm::destroy(dean1);
 
     std::cout << "Scenario 2" << std::endl;
     mm_print_memory_usage();
@@ -73,7 +74,7 @@ int main() {
     std::cout << "Buffer to the next stage: ";
     getline(std::cin, buffer_input);
 
-    XFREE(dean2);
+    deans = mm::vector<Dean>(); /* Destroys both deans and frees their block */
 
     std::cout << "Scenario 4" << std::endl;
     mm_print_memory_usage();
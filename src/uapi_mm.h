@@ -3,38 +3,410 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
+#include <atomic>
 
-/* Initialize the global page size for the memory manager */
+/* Opaque handle of a registered structure family */
+struct StructureFamily;
+
+/* Opaque handle of a region */
+struct MmRegion;
+
+
+/* Index used by a structure family to keep track of its free blocks */
+enum mm_free_list_policy_t {
+    MM_FREE_LIST_WORST_FIT,         /* Size ordered list, the biggest block is taken */
+    MM_FREE_LIST_SEGREGATED_FIT,    /* Bitmap indexed size class bins, O(1) insert/remove/lookup */
+    MM_FREE_LIST_BEST_FIT,          /* Same bins, the smallest block that fits is taken */
+    MM_FREE_LIST_ADDRESS_ORDERED    /* Address ordered list, the lowest block that fits is taken */
+};
+
+/* What happens to the memory of an empty page retained in the global page cache */
+enum mm_page_cache_decay_t {
+    MM_PAGE_CACHE_DECAY_NONE,       /* Page stays resident */
+    MM_PAGE_CACHE_DECAY_FREE,       /* MADV_FREE, kernel reclaims it lazily under pressure */
+    MM_PAGE_CACHE_DECAY_DONTNEED    /* MADV_DONTNEED, released at once, zero filled on reuse */
+};
+
+
+/* How arenas are backed by huge pages to cut TLB misses */
+enum mm_huge_page_mode_t {
+    MM_HUGE_PAGES_NONE,
+    MM_HUGE_PAGES_TRANSPARENT,  /* madvise(MADV_HUGEPAGE) on huge page aligned arenas */
+    MM_HUGE_PAGES_HUGETLB       /* MAP_HUGETLB from the hugetlbfs pool, transparent if the pool is empty */
+};
+
+
+/* Where pages for application are placed on a NUMA host */
+enum mm_numa_policy_t {
+    MM_NUMA_NONE,   /* Kernel placement, on the node that first touches a page */
+    MM_NUMA_LOCAL   /* On the node of the CPU the allocating thread runs on */
+};
+
+
+/* No NUMA node, the page placement is left to the thread or the policy */
+const int MM_NUMA_NODE_ANY = -1;
+
+
+/* Options of the memory manager, given once to 'mm_init' */
+struct MmInitOptions {
+    /* Guard structure families with locks so the manager can be
+     * used from several threads at once */
+    bool thread_safe{false};
+    /* Single unit blocks each thread keeps per family (thread safe mode),
+     * and how many of them move per refill or flush */
+    uint32_t thread_cache_capacity{32};
+    uint32_t thread_cache_batch{16};
+    /* Single unit blocks each CPU keeps per family between the thread
+     * caches and the family locks (thread safe mode), thread caches refill
+     * from and flush to the cache of the CPU they run on, 0 disables it.
+     * Off by default until it shows a gain over the thread caches alone */
+    uint32_t cpu_cache_capacity{0};
+    /* Freeing a data block does not take the family lock (thread safe 
+     * mode), thread cache overflows and multi unit blocks are pushed with
+     * a single CAS on a lock free stack of their family which the next
+     * allocation taking the family lock drains, large objects are still
+     * unmapped by 'xfree' */
+    bool remote_free{false};
+    /* High-water marks of empty pages kept for reuse instead of being
+     * unmapped, per structure family first, then in a global pool */
+    uint32_t page_cache_family_max{1};
+    uint32_t page_cache_global_max{16};
+    mm_page_cache_decay_t page_cache_decay{MM_PAGE_CACHE_DECAY_NONE};
+    /* VM pages of freed runs each page run size class of the byte oriented
+     * 'xmalloc' keeps for reuse instead of unmapping them, one run at least */
+    uint32_t page_cache_run_pages{256};
+    /* Address space is reserved in arenas of this many bytes (a power of two)
+     * with one mmap each and carved into pages, 0 maps page by page */
+    size_t arena_size{2 * 1024 * 1024};
+    /* Back arenas with huge pages, arenas grow to at least one huge page,
+     * pages in the global page cache do not decay so huge pages stay whole */
+    mm_huge_page_mode_t huge_pages{MM_HUGE_PAGES_NONE};
+    /* Fault in every mapping up front instead of on first touch */
+    bool prefault{false};
+    /* Map application pages executable, they are read and write only otherwise */
+    bool executable{false};
+    /* Place pages on NUMA nodes, arenas and the global page cache are kept 
+     * per node, a family or thread bound to a node overrides the policy */
+    mm_numa_policy_t numa_policy{MM_NUMA_NONE};
+    /* Pages placed on a node never spill to another one (MPOL_BIND),
+     * the node is only preferred otherwise (MPOL_PREFERRED) */
+    bool numa_strict{false};
+};
+
+
+/* Initialize the global page size for the memory manager, in thread safe
+ * mode its locks are held across 'fork' so the child can keep allocating */
 void mm_init(); 
 
+void mm_init(const MmInitOptions &options);
+
+
+/* Largest alignment of a structure family or an aligned allocation */
+const uint32_t MM_MAX_ALIGNMENT = 1024;
+
+
+/* Instantiate new structure family and accommodate it into the page for families,
+ * its data blocks start on an 'alignment' boundary (a power of two),
+ * returns a stable handle of the family */
+StructureFamily *mm_instantiate_new_structure_family(std::string struct_name, 
+    uint32_t struct_size, uint32_t alignment = 1);
 
-/* Instantiate new structure family and accommodate it into the page for families */
-void mm_instantiate_new_structure_family(std::string struct_name, uint32_t struct_size);
+
+/* Find a registered structure family by name through the hashed name index */
+StructureFamily *mm_lookup_structure_family_by_name(const std::string &struct_name);
+
+
+/* Family handle of a type, resolved once when the type is registered,
+ * atomic as threads may resolve it by name at the same time */
+template <typename T>
+inline std::atomic<StructureFamily*> mm_structure_family_handle{nullptr};
+
+
+/* Resolve the family handle of a type, falling back to the name lookup
+ * only on the first call if the type was registered by name, every
+ * thread looking it up stores the same family */
+template <typename T>
+inline StructureFamily *mm_get_structure_family_handle(const char *struct_name) {
+    StructureFamily *structure_family = 
+        mm_structure_family_handle<T>.load(std::memory_order_acquire);
+    if (structure_family == nullptr) {
+        structure_family = mm_lookup_structure_family_by_name(struct_name);
+        if (structure_family) {
+            mm_structure_family_handle<T>.store(structure_family, std::memory_order_release);
+        }
+    }
+    return structure_family;
+}
 
 #define MM_REG_STRUCT(struct_name) \
-(mm_instantiate_new_structure_family(#struct_name, sizeof(struct_name))) // '#' converts macro param name to string 
+(mm_structure_family_handle<struct_name> = \
+    mm_instantiate_new_structure_family(#struct_name, sizeof(struct_name), \
+        alignof(struct_name))) // '#' converts macro param name to string 
+
+
+/* Select the free block index of a structure family,
+ * free blocks already in the family are moved to the new index */
+void mm_set_structure_family_free_list_policy(
+        StructureFamily *structure_family, mm_free_list_policy_t policy);
+
+
+/* Serve single units of a structure family from slab pages: equal slots
+ * without a meta block per object, O(1) allocation and deallocation */
+void mm_set_structure_family_slab_mode(StructureFamily *structure_family, bool enable);
+
+
+/* Place the new pages of a structure family on a NUMA node, pages held
+ * already stay where they are, MM_NUMA_NODE_ANY undoes the binding */
+void mm_set_structure_family_numa_node(StructureFamily *structure_family, int numa_node);
+
+
+/* Place the new pages the calling thread gets for families not bound 
+ * to a node on a NUMA node, MM_NUMA_NODE_ANY undoes the binding */
+void mm_set_thread_numa_node(int numa_node);
 
 
 /* Screen out all the registered structure families*/
 void mm_print_registered_structure_families();
 
 
-/* Public function and macro called by the 
- * application for dynamic memory allocation */
+/* Public functions and macro called by the 
+ * application for dynamic memory allocation, every allocation 
+ * returns nullptr if the kernel is out of memory */
+void *xcalloc(StructureFamily *structure_family, int units);
+
 void *xcalloc(std::string struct_name, int units);
 
 #define XCALLOC(units, struct_name) \
-    xcalloc(#struct_name, units)
+    xcalloc(mm_get_structure_family_handle<struct_name>(#struct_name), units)
+
+
+/* Typed allocation on the family handle resolved at registration time */
+template <typename T>
+inline T *XCALLOC_T(int units) {
+    return static_cast<T*>(xcalloc(mm_structure_family_handle<T>, units));
+}
+
+
+/* Zero filled allocation starting on an 'alignment' boundary (a power of two
+ * up to MM_MAX_ALIGNMENT), e.g. a cache line or a SIMD register width,
+ * the padding in front is given back as a free block */
+void *xcalloc_aligned(StructureFamily *structure_family, int units, uint32_t alignment);
+
+#define XCALLOC_ALIGNED(units, struct_name, alignment) \
+    xcalloc_aligned(mm_get_structure_family_handle<struct_name>(#struct_name), units, alignment)
+
+
+/* Public functions and macro for dynamic memory allocation without
+ * zero filling, for callers overwriting the memory anyway */
+void *xmalloc(StructureFamily *structure_family, int units);
+
+void *xmalloc(std::string struct_name, int units);
+
+#define XMALLOC(units, struct_name) \
+    xmalloc(mm_get_structure_family_handle<struct_name>(#struct_name), units)
+
+template <typename T>
+inline T *XMALLOC_T(int units) {
+    return static_cast<T*>(xmalloc(mm_structure_family_handle<T>, units));
+}
+
+
+/* Largest request served by the size class families of the byte oriented
+ * 'xmalloc' from slab or block pages, requests above a quarter of a VM page
+ * share block pages instead of slab pages, bigger ones get a run of pages
+ * of their own, from a size class per run length up to a few pages */
+const size_t MM_SIZE_CLASS_MAX = 2048;
+
+
+/* Allocate 'size' bytes of any type from the internal size class families,
+ * registered on first use, zero filled (xcalloc) or not (xmalloc), the data
+ * block is aligned for any fundamental type and given back by 'xfree',
+ * nullptr if the size cannot be mapped */
+void *xmalloc(size_t size);
+
+void *xcalloc(size_t size);
+
+/* Same as 'xmalloc' with the data block starting on an 'alignment' boundary
+ * (a power of two up to MM_MAX_ALIGNMENT) */
+void *xmalloc_aligned(size_t size, uint32_t alignment);
+
+
+/* Check if a pointer lies in a page the memory manager holds for its
+ * families or regions, tells its data blocks apart from another
+ * allocator's memory */
+bool mm_is_managed_data_block(const void *app_data);
+
+
+/* Bytes of a data block the application may use, at least the bytes or
+ * units asked for, 0 for region objects */
+size_t mm_usable_size(void *app_data);
 
 
 /* Public function and macro called by the 
- * application for dynamic memory deallocation */
+ * application for dynamic memory deallocation, a double free terminates
+ * the program, except for a large page run already unmapped: reading its
+ * header again is undefined behaviour */
 void xfree(void *app_data);
 
 #define XFREE(data_block_ptr) \
     xfree(data_block_ptr)
 
 
+/* Allocate 'count' zero filled data blocks of 'units' each into 'app_data_array'
+ * under one family lock, carving many blocks out of a page in a single pass,
+ * returns the number of data blocks allocated */
+int xcalloc_batch(StructureFamily *structure_family, int units, int count, void **app_data_array);
+
+
+/* Free 'count' data blocks at once, blocks of the same page are coalesced 
+ * in one pass, null pointers are skipped and 'app_data_array' is reordered */
+void xfree_batch(void **app_data_array, int count);
+
+
+/* Create a region, objects of any family allocated from it are bump allocated
+ * on pages of its own and released all together by 'mm_region_destroy',
+ * a region is used by one thread at a time */
+MmRegion *mm_region_create();
+
+
+/* Give every page of the region back, the objects need no 'xfree' */
+void mm_region_destroy(MmRegion *region);
+
+
+/* Allocate 'units' of a structure family from a region, zero filled (xcalloc)
+ * or not (xmalloc), 'xfree' of a region object does nothing */
+void *xcalloc_region(MmRegion *region, StructureFamily *structure_family, int units);
+
+void *xmalloc_region(MmRegion *region, StructureFamily *structure_family, int units);
+
+#define XCALLOC_REGION(region, units, struct_name) \
+    xcalloc_region(region, mm_get_structure_family_handle<struct_name>(#struct_name), units)
+
+
+/* Resize a data block to 'units' of its structure family, in place when
+ * the page has room, moved otherwise to a block on the alignment it was
+ * allocated with, the memory grown is zero filled */
+void *xrealloc(void *app_data, int units);
+
+#define XREALLOC(data_block_ptr, units) \
+    xrealloc(data_block_ptr, units)
+
+
+/* Give all the blocks cached by the calling thread back to their
+ * structure families, or to the CPU cache if enabled (thread safe 
+ * mode only, done on thread exit too) */
+void mm_thread_cache_flush();
+
+
+/* Give all the blocks cached by every CPU back to their structure
+ * families, a thread cache flush leaves its blocks to the CPU cache */
+void mm_cpu_cache_flush();
+
+
+/* Return every empty page retained by the page caches back to kernel */
+void mm_page_cache_release();
+
+
+/* Counters of one structure family, read without walking the pages */
+struct MmFamilyStats {
+    std::string struct_name;
+    uint32_t struct_size{0};
+    uint64_t pages{0};              /* VM pages held, block, slab and large pages */
+    uint64_t cached_pages{0};       /* Empty pages and freed runs retained by the family */
+    uint64_t allocated_blocks{0};   /* Live data blocks of the application */
+    uint64_t free_blocks{0};        /* Free meta blocks waiting for reuse */
+    uint64_t bytes_requested{0};    /* Live bytes asked for by the application */
+    uint64_t bytes_consumed{0};     /* Live bytes taken, meta blocks and slot padding included */
+    uint64_t peak_bytes_consumed{0};
+    uint64_t alloc_count{0};
+    uint64_t free_count{0};
+};
+
+
+/* Memory of one NUMA node, node MM_NUMA_NODE_ANY is the memory left
+ * to the kernel placement */
+struct MmNumaNodeStats {
+    int node{MM_NUMA_NODE_ANY};
+    uint64_t pages{0};              /* VM pages of the families and regions */
+    uint64_t cached_pages{0};       /* Empty pages in the global page cache of the node */
+    uint64_t arenas{0};
+};
+
+
+/* Snapshot of the memory manager statistics */
+struct MmStats {
+    std::vector<MmFamilyStats> families;
+    std::vector<MmNumaNodeStats> numa_nodes; /* Nodes holding any memory only */
+    uint64_t arenas{0};
+    uint64_t global_cached_pages{0};    /* Empty pages in the global page cache */
+    uint64_t pages{0};                  /* Sum over the families */
+    uint64_t bytes_requested{0};
+    uint64_t bytes_consumed{0};
+    uint64_t regions{0};                /* Regions alive and the pages they hold */
+    uint64_t region_pages{0};
+};
+
+
+/* Read the statistics of all the registered structure families,
+ * costs O(families) and no page is touched */
+MmStats mm_get_stats();
+
+
+/* Statistics as a JSON document */
+std::string mm_stats_to_json(const MmStats &stats);
+
+
+/* A page kept mapped by only a few live data blocks */
+struct MmSparsePage {
+    const void *page{nullptr};
+    bool slab{false};
+    uint32_t live_blocks{0};
+    uint32_t used_bytes{0};
+    double occupancy{0};            /* Used bytes over the allocatable bytes of the page */
+};
+
+
+/* Buckets of the page occupancy histogram, 10% each */
+const uint32_t MM_OCCUPANCY_BUCKETS = 10;
+
+
+/* Heap layout of one structure family */
+struct MmFamilyFragmentation {
+    std::string struct_name;
+    uint32_t struct_size{0};
+    uint64_t pages{0};
+    uint64_t free_bytes{0};                 /* Free data bytes of the block pages */
+    uint64_t largest_free_block{0};
+    double external_fragmentation{0};       /* 1 - largest free block / free bytes */
+    uint64_t hard_internal_frag_bytes{0};   /* Gaps too small for a meta block, lost until a neighbour is freed */
+    uint64_t soft_internal_frag_bytes{0};   /* Free blocks too small to hold a single structure */
+    uint64_t soft_internal_frag_blocks{0};
+    uint64_t meta_data_bytes{0};            /* Meta blocks of the block pages */
+    uint64_t free_slab_slots{0};
+    uint64_t large_tail_bytes{0};           /* Unused tail of the large page runs */
+    uint32_t occupancy_histogram[MM_OCCUPANCY_BUCKETS]{};
+    std::vector<MmSparsePage> sparse_pages;
+};
+
+
+/* Fragmentation analysis of every registered structure family */
+struct MmFragmentationReport {
+    double sparse_page_occupancy{0};
+    std::vector<MmFamilyFragmentation> families;
+};
+
+
+/* Walk every page of every family and measure fragmentation, pages used 
+ * below 'sparse_page_occupancy' are listed as pinning memory, an O(heap) 
+ * walk holding each family lock, blocks in thread caches count as allocated */
+MmFragmentationReport mm_analyze_fragmentation(double sparse_page_occupancy = 0.25);
+
+
+/* Print a fragmentation report with hints on families and free patterns */
+void mm_print_fragmentation_report(const MmFragmentationReport &report);
+
+
 /* Iterate all the page families which have registered
  * within the memory manager, and print the memory usage
  * inside the vm pages */
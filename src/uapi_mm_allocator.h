@@ -0,0 +1,158 @@
+#ifndef __UAPI_MM_ALLOCATOR__
+#define __UAPI_MM_ALLOCATOR__
+#include <new>
+#include <memory>
+#include <utility>
+#include <limits>
+#include <string>
+#include <typeinfo>
+#include <type_traits>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include "uapi_mm.h"
+
+namespace mm {
+
+/* Structure family serving the objects of type T for the STL allocator
+ * and 'mm::make', a type registered with 'MM_REG_STRUCT' keeps its family,
+ * any other type is registered on first use under its type name */
+template <typename T>
+inline StructureFamily *family_allocator_family() {
+    static_assert(alignof(T) <= MM_MAX_ALIGNMENT,
+        "Alignment of the type is above MM_MAX_ALIGNMENT");
+    StructureFamily *registered_family = 
+        mm_structure_family_handle<T>.load(std::memory_order_acquire);
+    if (registered_family) {
+        return registered_family;
+    }
+    static StructureFamily *structure_family = mm_instantiate_new_structure_family(
+        std::string("mm::") + typeid(T).name(), sizeof(T), alignof(T));
+    return structure_family;
+}
+
+
+/* STL allocator carving the elements or nodes of a container out of the
+ * structure family of their type, a node based container (std::list,
+ * std::map, std::unordered_map) rebinds it to its node type so every node
+ * is a single unit served by the thread cache, arrays (std::vector,
+ * std::string) are multi unit data blocks, or large objects beyond a page.
+ * The allocator holds no state, memory of any instance is freed by any
+ * other. The memory manager must be initialized first */
+template <typename T>
+struct family_allocator {
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type is_always_equal;
+
+    family_allocator() noexcept = default;
+
+    template <typename U>
+    family_allocator(const family_allocator<U> &) noexcept {}
+
+    T *allocate(std::size_t n) {
+        if (n > (std::size_t)std::numeric_limits<int>::max()) {
+            throw std::bad_array_new_length();
+        }
+        void *app_data = xmalloc(family_allocator_family<T>(), (int)n);
+        if (app_data == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(app_data);
+    }
+
+    void deallocate(T *ptr, std::size_t) noexcept {
+        xfree(ptr);
+    }
+};
+
+template <typename T, typename U>
+inline bool operator==(const family_allocator<T> &, const family_allocator<U> &) noexcept {
+    return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const family_allocator<T> &, const family_allocator<U> &) noexcept {
+    return false;
+}
+
+
+/* Containers on the memory manager */
+template <typename T>
+using vector = std::vector<T, family_allocator<T>>;
+
+template <typename T>
+using list = std::list<T, family_allocator<T>>;
+
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using unordered_map = std::unordered_map<Key, T, Hash, KeyEqual,
+    family_allocator<std::pair<const Key, T>>>;
+
+using string = std::basic_string<char, std::char_traits<char>, family_allocator<char>>;
+
+
+/* Construct an object of type T from 'args' in a data block of its
+ * structure family, the block is not zero filled first, the constructor
+ * initializes the object (value initialized without arguments) */
+template <typename T, typename... Args>
+inline T *make(Args&&... args) {
+    static_assert(!std::is_array<T>::value, "Arrays are allocated with mm::vector");
+    void *app_data = xmalloc(family_allocator_family<T>(), 1);
+    if (app_data == nullptr) {
+        throw std::bad_alloc();
+    }
+    try {
+        return new (app_data) T(std::forward<Args>(args)...);
+    } catch (...) {
+        xfree(app_data);
+        throw;
+    }
+}
+
+
+/* Destroy an object built by 'mm::make' and free its data block, an object
+ * of a polymorphic type may be reached through a pointer to one of its bases */
+template <typename T>
+inline void destroy(T *object) noexcept {
+    const volatile void *app_data{object};
+
+    if (object == nullptr) {
+        return;
+    }
+    if constexpr (std::is_polymorphic<T>::value) {
+        app_data = dynamic_cast<const volatile void *>(object);
+    }
+    object->~T();
+    xfree(const_cast<void *>(app_data));
+}
+
+
+/* Deleter of the objects built by 'mm::make' */
+template <typename T>
+struct deleter {
+    deleter() noexcept = default;
+
+    template <typename U, typename = typename std::enable_if<
+        std::is_convertible<U *, T *>::value>::type>
+    deleter(const deleter<U> &) noexcept {}
+
+    void operator()(T *object) const noexcept {
+        destroy(object);
+    }
+};
+
+
+/* Owning pointer to an object of the memory manager */
+template <typename T>
+using unique_ptr = std::unique_ptr<T, deleter<T>>;
+
+
+template <typename T, typename... Args>
+inline unique_ptr<T> make_unique(Args&&... args) {
+    return unique_ptr<T>(make<T>(std::forward<Args>(args)...));
+}
+
+}
+
+#endif /* __UAPI_MM_ALLOCATOR__ */
@@ -0,0 +1,55 @@
+#include <iostream>
+#include <new>
+#include <sys/resource.h>
+#include "uapi_mm.h"
+#include "uapi_mm_allocator.h"
+
+/* Containers on the memory manager see a request it cannot serve as
+ * std::bad_alloc, and keep their elements */
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        return 1; \
+    }
+
+struct record_t {
+    char bytes[1024];
+};
+
+/* Reserve 'count' elements, returns true if std::bad_alloc was thrown */
+template <typename T>
+static bool reserve_throws_bad_alloc(mm::vector<T> &vector, size_t count) {
+    try {
+        vector.reserve(count);
+    } catch (const std::bad_alloc &) {
+        return true;
+    }
+    return false;
+}
+
+int main() {
+    mm_init();
+    MM_REG_STRUCT(record_t);
+
+    mm::vector<record_t> records(10);
+    records[9].bytes[0] = 'x';
+
+    /* Beyond the 'int' units of a request */
+    CHECK(reserve_throws_bad_alloc(records, (size_t)1 << 32));
+
+    /* Units in range but more than the address space left, 16 GiB */
+    struct rlimit limit;
+    limit.rlim_cur = limit.rlim_max = (rlim_t)1 << 32;
+    CHECK(setrlimit(RLIMIT_AS, &limit) == 0);
+    CHECK(reserve_throws_bad_alloc(records, (size_t)1 << 24));
+    CHECK(records.size() == 10 && records[9].bytes[0] == 'x');
+
+    /* Types not registered get a family of their own */
+    mm::vector<long> numbers;
+    CHECK(reserve_throws_bad_alloc(numbers, (size_t)1 << 30));
+    numbers.assign(1000, 7);
+    CHECK(numbers.size() == 1000 && numbers[999] == 7);
+    std::cout << "allocator out of memory: OK" << std::endl;
+    return 0;
+}
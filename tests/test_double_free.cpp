@@ -0,0 +1,150 @@
+#include <iostream>
+#include <string>
+#include <functional>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "uapi_mm.h"
+
+/* A double free must be reported however the first free was served, by a
+ * thread cache, the family, a slab page or a page run, each case runs in
+ * a child process since the memory manager terminates on it */
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        return 1; \
+    }
+
+struct node_t {
+    long key;
+    node_t *next;
+};
+
+/* Run 'scenario' in a child process on a fresh memory manager,
+ * returns true if it was terminated by a double free report */
+static bool detects_double_free(const MmInitOptions &options,
+        std::function<void(StructureFamily *)> scenario) {
+    int stderr_pipe[2];
+    int status{0};
+    std::string report;
+    char buffer[256];
+    ssize_t bytes{0};
+
+    if (pipe(stderr_pipe) != 0) {
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(stderr_pipe[1], STDERR_FILENO);
+        close(stderr_pipe[0]);
+        mm_init(options);
+        scenario(MM_REG_STRUCT(node_t));
+        _exit(0);
+    }
+    close(stderr_pipe[1]);
+    while ((bytes = read(stderr_pipe[0], buffer, sizeof(buffer))) > 0) {
+        report.append(buffer, bytes);
+    }
+    close(stderr_pipe[0]);
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 255 &&
+        report.find("Double free detected") != std::string::npos;
+}
+
+int main() {
+    MmInitOptions thread_safe;
+    thread_safe.thread_safe = true;
+    MmInitOptions cpu_cache = thread_safe;
+    cpu_cache.cpu_cache_capacity = 64;
+    MmInitOptions remote_free = thread_safe;
+    remote_free.remote_free = true;
+
+    /* Single unit freed into the thread cache */
+    CHECK(detects_double_free(thread_safe, [](StructureFamily *family) {
+        void *a = xmalloc(family, 1);
+        xfree(a);
+        xfree(a);
+    }));
+    /* Same through the CPU cache, the block left the thread cache in between */
+    CHECK(detects_double_free(cpu_cache, [](StructureFamily *family) {
+        void *a = xmalloc(family, 1);
+        xfree(a);
+        mm_thread_cache_flush();
+        xfree(a);
+    }));
+    /* Stale pointer to a block given back to the family and cached again */
+    CHECK(detects_double_free(thread_safe, [](StructureFamily *family) {
+        void *a = xmalloc(family, 1);
+        void *b = xmalloc(family, 1);
+        xfree(a);
+        mm_thread_cache_flush();
+        xfree(xmalloc(family, 1));
+        xfree(a);
+        xfree(b);
+    }));
+    /* Slab slot of a size class, cached and not */
+    CHECK(detects_double_free(thread_safe, [](StructureFamily *) {
+        void *a = xmalloc(24);
+        xfree(a);
+        xfree(a);
+    }));
+    CHECK(detects_double_free(MmInitOptions(), [](StructureFamily *) {
+        void *a = xmalloc(24);
+        xfree(a);
+        xfree(a);
+    }));
+    /* Multi unit block waiting on the remote free stack */
+    CHECK(detects_double_free(remote_free, [](StructureFamily *family) {
+        void *a = xmalloc(family, 3);
+        xfree(a);
+        xfree(a);
+    }));
+    /* Single unit pushed to the remote free stack by a full thread cache */
+    CHECK(detects_double_free(remote_free, [](StructureFamily *family) {
+        void *blocks[64];
+        for (void *&block: blocks) {
+            block = xmalloc(family, 1);
+        }
+        for (void *block: blocks) {
+            xfree(block);
+        }
+        xfree(blocks[0]);
+    }));
+    /* The same block twice in a batch */
+    CHECK(detects_double_free(MmInitOptions(), [](StructureFamily *family) {
+        void *blocks[3] = {xmalloc(family, 2), xmalloc(family, 2), nullptr};
+        blocks[2] = blocks[0];
+        xfree_batch(blocks, 3);
+    }));
+    CHECK(detects_double_free(MmInitOptions(), [](StructureFamily *family) {
+        void *blocks[3] = {xmalloc(family, 1000), xmalloc(family, 1000), nullptr};
+        blocks[2] = blocks[0];
+        xfree_batch(blocks, 3);
+    }));
+
+    /* Large page run of a single page, kept mapped by the page cache */
+    CHECK(detects_double_free(MmInitOptions(), [](StructureFamily *) {
+        void *a = xmalloc_aligned(3000, 1024);
+        xfree(a);
+        xfree(a);
+    }));
+
+    /* A block freed once and handed out again is not reported */
+    CHECK(!detects_double_free(thread_safe, [](StructureFamily *family) {
+        for (int i = 0; i < 1000; i++) {
+            void *a = xmalloc(family, 1);
+            void *b = xmalloc(24);
+            xfree(a);
+            xfree(b);
+        }
+        void *a = xmalloc(family, 1);
+        void *b = xmalloc(family, 1);
+        if (a == b) {
+            _exit(1);
+        }
+        void *blocks[2] = {a, b};
+        xfree_batch(blocks, 2);
+    }));
+    std::cout << "double free detection: OK" << std::endl;
+    return 0;
+}
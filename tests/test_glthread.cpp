@@ -0,0 +1,87 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstddef>
+#include "gluethread/glthread.h"
+
+/* Ordering of 'glthread_priority_insert', the free block lists of the
+ * worst fit and address ordered policies rely on it */
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        return 1; \
+    }
+
+struct node_t {
+    int key;
+    glthread_t glue;
+};
+
+static int ascending(void *a, void *b) {
+    int key_a = static_cast<node_t *>(a)->key, key_b = static_cast<node_t *>(b)->key;
+    return (key_a < key_b) ? -1 : (key_a > key_b) ? 1 : 0;
+}
+
+static int descending(void *a, void *b) {
+    return ascending(b, a);
+}
+
+static node_t *glue_to_node(glthread_t *glthreadptr) {
+    return (node_t *)((char *)glthreadptr - offsetof(node_t, glue));
+}
+
+/* Keys of the list from head to tail */
+static std::vector<int> list_keys(glthread_t *head) {
+    std::vector<int> keys;
+    glthread_t *curr = nullptr;
+    ITERATE_GLTHREAD_BEGIN(head, curr) {
+        keys.push_back(glue_to_node(curr)->key);
+    } ITERATE_GLTHREAD_END(head, curr);
+    return keys;
+}
+
+/* Insert the keys in the given order and return the list keys */
+static std::vector<int> insert_keys(std::vector<node_t> &nodes, glthread_t *head,
+        int (*comp_fn)(void *, void *)) {
+    init_glthread(head);
+    for (auto &node: nodes) {
+        glthread_priority_insert(head, &node.glue, comp_fn, offsetof(node_t, glue));
+    }
+    return list_keys(head);
+}
+
+int main() {
+    glthread_t head;
+    std::vector<node_t> nodes;
+
+    for (int key: {1, 5, 3, 4, 2}) {
+        nodes.push_back({key, {}});
+    }
+    CHECK(insert_keys(nodes, &head, ascending) == std::vector<int>({1, 2, 3, 4, 5}));
+    CHECK(insert_keys(nodes, &head, descending) == std::vector<int>({5, 4, 3, 2, 1}));
+
+    /* Equal keys and every insertion order of a random sequence */
+    std::mt19937 rng(42);
+    nodes.clear();
+    for (int i = 0; i < 500; i++) {
+        nodes.push_back({(int)(rng() % 64), {}});
+    }
+    std::vector<int> keys = insert_keys(nodes, &head, ascending);
+    CHECK(keys.size() == nodes.size() && std::is_sorted(keys.begin(), keys.end()));
+    keys = insert_keys(nodes, &head, descending);
+    CHECK(keys.size() == nodes.size() && std::is_sorted(keys.rbegin(), keys.rend()));
+
+    /* Taking the head over and over yields the keys in order, as the
+     * worst fit policy does with the biggest free block */
+    int prev_key = 64;
+    while (head.right) {
+        node_t *first = glue_to_node(head.right);
+        CHECK(first->key <= prev_key);
+        prev_key = first->key;
+        remove_glthread(&first->glue);
+    }
+    std::cout << "glthread priority insert: OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include <iostream>
+#include <string>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "uapi_mm.h"
+
+/* A request the kernel cannot map is answered with a null data block,
+ * silently, and the memory manager keeps serving the requests it can,
+ * each case runs in a child process with its address space capped */
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        return 1; \
+    }
+
+struct record_t {
+    char bytes[100];
+};
+
+/* Address space of the calling process, in bytes */
+static size_t address_space_size() {
+    size_t pages{0};
+    FILE *statm = fopen("/proc/self/statm", "r");
+
+    if (statm) {
+        if (fscanf(statm, "%zu", &pages) != 1) {
+            pages = 0;
+        }
+        fclose(statm);
+    }
+    return pages * getpagesize();
+}
+
+/* Run 'scenario' in a child process on a fresh memory manager with
+ * 'headroom' bytes of address space left, returns true if it returned
+ * true and wrote nothing to stderr */
+static bool runs_silently(const MmInitOptions &options, size_t headroom,
+        std::function<bool(StructureFamily *)> scenario) {
+    int stderr_pipe[2];
+    int status{0};
+    std::string report;
+    char buffer[256];
+    ssize_t bytes{0};
+
+    if (pipe(stderr_pipe) != 0) {
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(stderr_pipe[1], STDERR_FILENO);
+        close(stderr_pipe[0]);
+        mm_init(options);
+        StructureFamily *family = MM_REG_STRUCT(record_t);
+        struct rlimit limit;
+        limit.rlim_cur = limit.rlim_max = address_space_size() + headroom;
+        setrlimit(RLIMIT_AS, &limit);
+        _exit(scenario(family) ? 0 : 1);
+    }
+    close(stderr_pipe[1]);
+    while ((bytes = read(stderr_pipe[0], buffer, sizeof(buffer))) > 0) {
+        report.append(buffer, bytes);
+    }
+    close(stderr_pipe[0]);
+    waitpid(pid, &status, 0);
+    if (!report.empty()) {
+        std::cerr << report;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 && report.empty();
+}
+
+/* Single units are taken until the capped address space runs out */
+static bool exhausts_single_units(StructureFamily *family) {
+    void *app_data{nullptr};
+    for (int i = 0; i < (1 << 20); i++) {
+        app_data = xmalloc(family, 1);
+        if (app_data == nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main() {
+    const size_t headroom = 16 << 20;
+    MmInitOptions thread_safe;
+    thread_safe.thread_safe = true;
+    MmInitOptions arenas;
+    arenas.arena_size = 64 << 20;
+
+    /* Page runs of the size classes and of a family */
+    CHECK(runs_silently(MmInitOptions(), headroom, [](StructureFamily *family) {
+        void *small = xmalloc(64);
+        return xmalloc((size_t)1 << 30) == nullptr && xcalloc((size_t)1 << 30) == nullptr &&
+            xmalloc_aligned((size_t)1 << 30, 1024) == nullptr &&
+            xmalloc(~(size_t)0 >> 1) == nullptr && xmalloc(family, 1 << 24) == nullptr &&
+            xrealloc(small, 1 << 30) == nullptr && small && xmalloc(64) != nullptr;
+    }));
+    CHECK(runs_silently(MmInitOptions(), headroom, [](StructureFamily *family) {
+        void *app_data_array[4];
+        return xcalloc_batch(family, 1 << 24, 4, app_data_array) == 0;
+    }));
+
+    /* Pages of blocks, of slabs and of arenas, through the thread cache */
+    CHECK(runs_silently(MmInitOptions(), headroom, exhausts_single_units));
+    CHECK(runs_silently(thread_safe, headroom, exhausts_single_units));
+    CHECK(runs_silently(arenas, headroom, exhausts_single_units));
+    CHECK(runs_silently(MmInitOptions(), headroom, [](StructureFamily *family) {
+        mm_set_structure_family_slab_mode(family, true);
+        return exhausts_single_units(family);
+    }));
+    CHECK(runs_silently(MmInitOptions(), headroom, [](StructureFamily *) {
+        for (int i = 0; i < (1 << 20); i++) {
+            if (xmalloc(1000) == nullptr) {
+                return true;
+            }
+        }
+        return false;
+    }));
+
+    /* A child forked while other threads allocate can allocate too */
+    CHECK(runs_silently(thread_safe, (size_t)1 << 30, [](StructureFamily *family) {
+        std::atomic<bool> stop{false};
+        std::thread worker([&stop, family]() {
+            while (!stop.load()) {
+                xfree(xmalloc(family, 3));
+                xfree(xmalloc(64));
+            }
+        });
+        bool forked_ok = true;
+        for (int i = 0; i < 200 && forked_ok; i++) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                alarm(10);
+                xfree(xmalloc(family, 3));
+                xfree(xmalloc(64));
+                _exit(0);
+            }
+            int status{0};
+            waitpid(pid, &status, 0);
+            forked_ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        }
+        stop.store(true);
+        worker.join();
+        return forked_ok;
+    }));
+    std::cout << "out of memory: OK" << std::endl;
+    return 0;
+}
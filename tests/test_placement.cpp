@@ -0,0 +1,73 @@
+#include <iostream>
+#include <string>
+#include "uapi_mm.h"
+
+/* Each free block index places a request where its policy says: the
+ * biggest free block, the smallest one that fits, or the lowest one */
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        return 1; \
+    }
+
+struct unit_t {
+    char bytes[16];
+};
+
+/* Free blocks of 4, 8 and 2 units kept apart by live single units,
+ * in this address order and followed by the free rest of the page,
+ * freed out of order so the middle one is inserted between the others */
+struct Layout {
+    char *free_4;
+    char *free_8;
+    char *free_2;
+    char *last_separator;
+};
+
+static Layout make_layout(StructureFamily *family, mm_free_list_policy_t policy) {
+    Layout layout;
+
+    layout.free_4 = static_cast<char *>(xmalloc(family, 4));
+    xmalloc(family, 1);
+    layout.free_8 = static_cast<char *>(xmalloc(family, 8));
+    xmalloc(family, 1);
+    layout.free_2 = static_cast<char *>(xmalloc(family, 2));
+    layout.last_separator = static_cast<char *>(xmalloc(family, 1));
+    mm_set_structure_family_free_list_policy(family, policy);
+    xfree(layout.free_4);
+    xfree(layout.free_2);
+    xfree(layout.free_8);
+    return layout;
+}
+
+static StructureFamily *new_family(const std::string &name) {
+    return mm_instantiate_new_structure_family(name, sizeof(unit_t));
+}
+
+int main() {
+    mm_init();
+
+    /* Worst fit carves the free rest of the page, the biggest block */
+    StructureFamily *worst = new_family("worst");
+    Layout layout = make_layout(worst, MM_FREE_LIST_WORST_FIT);
+    CHECK(static_cast<char *>(xmalloc(worst, 2)) > layout.last_separator);
+
+    /* Best fit takes the exact 2 units block, then the 8 units one for 5 */
+    StructureFamily *best = new_family("best");
+    layout = make_layout(best, MM_FREE_LIST_BEST_FIT);
+    CHECK(xmalloc(best, 2) == layout.free_2);
+    CHECK(xmalloc(best, 5) == layout.free_8);
+
+    /* Address ordered takes the lowest block that fits, the rest of a split
+     * block keeps its place behind a 16 bytes meta block */
+    StructureFamily *address = new_family("address");
+    layout = make_layout(address, MM_FREE_LIST_ADDRESS_ORDERED);
+    CHECK(xmalloc(address, 2) == layout.free_4);
+    CHECK(xmalloc(address, 2) == layout.free_8);
+    CHECK(xmalloc(address, 6) > layout.last_separator);
+    CHECK(xmalloc(address, 5) == layout.free_8 + 2 * sizeof(unit_t) + 16);
+    CHECK(xmalloc(address, 2) == layout.free_2);
+    std::cout << "placement policies: OK" << std::endl;
+    return 0;
+}
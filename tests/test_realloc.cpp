@@ -0,0 +1,48 @@
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+#include "uapi_mm.h"
+
+/* 'xrealloc' keeps the content and the alignment of a data block, 
+ * whether it is resized in place or moved */
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        return 1; \
+    }
+
+struct cell_t {
+    uint32_t value;
+    uint32_t tag;
+};
+
+static bool is_aligned(void *app_data, uintptr_t alignment) {
+    return ((uintptr_t)app_data & (alignment - 1)) == 0;
+}
+
+int main() {
+    mm_init();
+    StructureFamily *family = MM_REG_STRUCT(cell_t);
+
+    /* Blocks in the way force the resized block to move */
+    for (uint32_t alignment: {64u, 256u, 1024u}) {
+        cell_t *cells = static_cast<cell_t *>(xcalloc_aligned(family, 4, alignment));
+        void *neighbour = xcalloc(family, 4);
+        CHECK(is_aligned(cells, alignment));
+        for (uint32_t i = 0; i < 4; i++) {
+            cells[i].value = i;
+        }
+        for (int units: {64, 200, 2000, 8}) {
+            cells = static_cast<cell_t *>(xrealloc(cells, units));
+            CHECK(cells && is_aligned(cells, alignment));
+            for (uint32_t i = 0; i < 4; i++) {
+                CHECK(cells[i].value == i);
+            }
+        }
+        xfree(cells);
+        xfree(neighbour);
+    }
+    std::cout << "xrealloc alignment: OK" << std::endl;
+    return 0;
+}
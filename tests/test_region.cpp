@@ -0,0 +1,42 @@
+#include <iostream>
+#include <cstdlib>
+#include "uapi_mm.h"
+
+/* Region objects are told apart from another allocator's memory while
+ * their region lives, so an interposed free() does not hand them on */
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        return 1; \
+    }
+
+struct record_t {
+    char bytes[100];
+};
+
+int main() {
+    mm_init();
+    StructureFamily *family = MM_REG_STRUCT(record_t);
+
+    MmRegion *region = mm_region_create();
+    CHECK(region != nullptr);
+    void *small = xmalloc_region(region, family, 1);
+    void *large = xmalloc_region(region, family, 100);
+    CHECK(small && large);
+    CHECK(mm_is_managed_data_block(small) && mm_is_managed_data_block(large));
+
+    /* 'xfree' of a region object does nothing */
+    xfree(small);
+    CHECK(mm_is_managed_data_block(small));
+
+    /* The first page goes to the page cache, the large run to kernel */
+    mm_region_destroy(region);
+    CHECK(!mm_is_managed_data_block(small));
+
+    void *foreign = malloc(64);
+    CHECK(!mm_is_managed_data_block(foreign));
+    free(foreign);
+    std::cout << "region pages: OK" << std::endl;
+    return 0;
+}
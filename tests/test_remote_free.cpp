@@ -0,0 +1,57 @@
+#include <iostream>
+#include "uapi_mm.h"
+
+/* With 'remote_free', blocks freed without the family lock are given
+ * back by the next allocation, except large page runs which are
+ * unmapped by 'xfree' itself */
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        return 1; \
+    }
+
+struct record_t {
+    char payload[100];
+};
+
+/* Pages held by the family of 'struct_name' */
+static uint64_t family_pages(const std::string &struct_name) {
+    for (const MmFamilyStats &family_stats: mm_get_stats().families) {
+        if (family_stats.struct_name == struct_name) {
+            return family_stats.pages;
+        }
+    }
+    return 0;
+}
+
+int main() {
+    MmInitOptions options;
+    options.thread_safe = true;
+    options.remote_free = true;
+    mm_init(options);
+    StructureFamily *family = MM_REG_STRUCT(record_t);
+
+    /* A large run goes back to kernel at once, no allocation follows */
+    void *large = xmalloc(family, 1000);
+    CHECK(large && family_pages("record_t") >= 25);
+    xfree(large);
+    CHECK(family_pages("record_t") == 0);
+
+    /* Multi unit blocks wait on the stack until an allocation drains it */
+    void *blocks[8];
+    for (void *&block: blocks) {
+        block = xmalloc(family, 4);
+    }
+    for (void *block: blocks) {
+        xfree(block);
+    }
+    CHECK(family_pages("record_t") > 0);
+    void *drain = xmalloc(family, 4);
+    CHECK(drain);
+    xfree(drain);
+    mm_thread_cache_flush();
+    CHECK(family_pages("record_t") == 0);
+    std::cout << "remote free: OK" << std::endl;
+    return 0;
+}
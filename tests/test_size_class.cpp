@@ -0,0 +1,105 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include "uapi_mm.h"
+
+/* Byte requests above MM_SIZE_CLASS_MAX get a run of pages from the page
+ * run size class of its length, which keeps the freed runs for reuse */
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        return 1; \
+    }
+
+/* Pages held and retained by the family of 'struct_name' */
+static MmFamilyStats family_stats_of(const std::string &struct_name) {
+    for (const MmFamilyStats &family_stats: mm_get_stats().families) {
+        if (family_stats.struct_name == struct_name) {
+            return family_stats;
+        }
+    }
+    return MmFamilyStats();
+}
+
+static bool is_zero_filled(const char *bytes, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (bytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    MmInitOptions options;
+    options.thread_safe = true;
+    mm_init(options);
+
+    /* A freed run is retained by its class and handed out again, zero
+     * filled for 'xcalloc' */
+    char *run = static_cast<char *>(xmalloc(10000));
+    CHECK(run && family_stats_of("mm_class_run_3").pages == 3);
+    memset(run, 0x5a, 10000);
+    xfree(run);
+    CHECK(family_stats_of("mm_class_run_3").pages == 0);
+    CHECK(family_stats_of("mm_class_run_3").cached_pages == 3);
+    char *reused = static_cast<char *>(xcalloc(10001));
+    CHECK(reused == run && is_zero_filled(reused, 10001));
+    CHECK(family_stats_of("mm_class_run_3").cached_pages == 0);
+
+    /* A run resized to another length keeps its content */
+    memset(reused, 0x5a, 10001);
+    char *grown = static_cast<char *>(xrealloc(reused, 40000 / 16));
+    CHECK(grown && grown[10000] == 0x5a);
+    xfree(grown);
+
+    /* An aligned request is placed in the class of its longer run */
+    void *aligned = xmalloc_aligned(4000, 1024);
+    CHECK(aligned && ((uintptr_t)aligned & 1023) == 0);
+    CHECK(family_stats_of("mm_class_run_2").pages == 2);
+    xfree(aligned);
+
+    /* Runs beyond the classes are still mapped on their own */
+    void *huge = xmalloc(1 << 20);
+    CHECK(huge && family_stats_of("mm_class_medium").pages >= 256);
+    xfree(huge);
+    CHECK(family_stats_of("mm_class_medium").pages == 0);
+
+    /* Threads allocating runs of every class keep their content */
+    std::vector<std::thread> threads;
+    bool intact[4] = {true, true, true, true};
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t, &intact]() {
+            std::vector<char *> live;
+            for (int i = 0; i < 20000; i++) {
+                size_t size = MM_SIZE_CLASS_MAX + 1 + (i * 7919) % (64 * 1024);
+                char *bytes = static_cast<char *>(xmalloc(size));
+                bytes[0] = bytes[size - 1] = (char)t;
+                live.push_back(bytes);
+                if (live.size() == 32) {
+                    for (char *old: live) {
+                        intact[t] = intact[t] && old[0] == (char)t;
+                        xfree(old);
+                    }
+                    live.clear();
+                }
+            }
+            for (char *old: live) {
+                xfree(old);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    CHECK(intact[0] && intact[1] && intact[2] && intact[3]);
+
+    /* Retained runs go back to kernel with the page caches */
+    mm_page_cache_release();
+    CHECK(family_stats_of("mm_class_run_3").cached_pages == 0);
+    std::cout << "size classes: OK" << std::endl;
+    return 0;
+}